@@ -2,13 +2,169 @@
  Tools for creating dynamic arrays in C - QUICK AND DIRTY
 */
 
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include "arrays.h"
 
+/*
+ Mapped arrays are recorded in a side table (start and size of the
+ mapping) rather than in a header, so that the whole mapping is array : an
+ array mapped under ARR_ALIGNED starts on a page boundary, under ARR_THP
+ and ARR_HUGETLB on a huge page boundary and fills whole huge pages.
+ Arrays missing from the table come from calloc.
+
+ Mapped arrays are zero and untouched when returned : each page is placed
+ on the NUMA node of the thread that first writes to it, so arrays should
+ be initialised by the thread that will work on them (see sim_alloc).
+*/
+
+#define ARR_HUGE_PAGE ((size_t) 2 << 20)  /* default huge page size of x86-64 and arm64 (4 KB pages) */
+
+typedef struct {
+	void *arr;    /* start of the array, and of its mapping */
+	size_t size;  /* bytes mapped */
+} ArrMapping;
+
+static int arr_policy = ARR_PLAIN;
+
+/* mapped arrays */
+static ArrMapping *maps = NULL;
+static int n_maps = 0, max_maps = 0;
+static pthread_mutex_t maps_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+arr_set_policy : choose how arr_alloc allocates arrays of at least
+				 ARR_MAP_MIN bytes (smaller arrays always use calloc)
+args :
+	policy : ARR_PLAIN, ARR_ALIGNED, ARR_THP or ARR_HUGETLB
+*/
+void arr_set_policy(int policy)
+{
+	if (policy < ARR_PLAIN || policy > ARR_HUGETLB)
+	{
+		fprintf(stderr, "Unknown allocation policy %d\n", policy);
+		exit(1);
+	}
+	arr_policy = policy;
+}
+
+int arr_get_policy(void)
+{
+	return arr_policy;
+}
+
+/* ints per base page of the kernel */
+size_t arr_page_ints(void)
+{
+	long page = sysconf(_SC_PAGESIZE);
+
+	return ((page > 0) ? (size_t) page : 4096) / sizeof(int);
+}
+
+/* anonymous mapping of 'size' bytes (rounded up to whole pages of the policy), NULL on failure */
+static void *arr_map(size_t *size, int policy)
+{
+	size_t page = arr_page_ints() * sizeof(int), align = page, span;
+	char *base, *arr;
+
+#ifdef MAP_HUGETLB
+	if (policy == ARR_HUGETLB)
+	{
+		span = (*size + ARR_HUGE_PAGE - 1) / ARR_HUGE_PAGE * ARR_HUGE_PAGE;
+		base = (char *) mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (base != MAP_FAILED)  /* huge page mappings start on a huge page boundary */
+		{
+			*size = span;
+			return base;
+		}
+		policy = ARR_THP;  /* no huge pages reserved */
+	}
+#endif
+
+	if (policy >= ARR_THP && ARR_HUGE_PAGE > page)
+	{
+		align = ARR_HUGE_PAGE;
+	}
+	*size = (*size + align - 1) / align * align;
+
+	/* map enough to move the start to an 'align' boundary, then drop the slack */
+	span = *size + align - page;
+	base = (char *) mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+	{
+		return NULL;
+	}
+	arr = (char *) (((uintptr_t) base + align - 1) / align * align);
+	if (arr > base)
+	{
+		munmap(base, arr - base);
+	}
+	if (arr + *size < base + span)
+	{
+		munmap(arr + *size, base + span - (arr + *size));
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (policy >= ARR_THP)
+	{
+		madvise(arr, *size, MADV_HUGEPAGE);  /* a hint, failure is harmless */
+	}
+#endif
+
+	return arr;
+}
+
+/* record a mapped array, 0 if the table cannot grow */
+static int arr_track(void *arr, size_t size)
+{
+	ArrMapping *grown;
+	int ok = 1;
+
+	pthread_mutex_lock(&maps_lock);
+	if (n_maps == max_maps)
+	{
+		grown = (ArrMapping *) realloc(maps, (max_maps + 16) * sizeof(ArrMapping));
+		if (grown == NULL)
+		{
+			ok = 0;
+		}
+		else
+		{
+			maps = grown;
+			max_maps += 16;
+		}
+	}
+	if (ok)
+	{
+		maps[n_maps].arr = arr;
+		maps[n_maps].size = size;
+		n_maps++;
+	}
+	pthread_mutex_unlock(&maps_lock);
+	return ok;
+}
+
 /* functions for 1D case */
-int *arr_alloc(int length)
+int *arr_alloc(size_t length)
 {
-	int *arr;
-	arr = (int *) calloc(length, sizeof(int));
+	size_t size = length * sizeof(int);
+	int *arr = NULL;
+
+	if (arr_policy != ARR_PLAIN && size >= ARR_MAP_MIN)
+	{
+		arr = (int *) arr_map(&size, arr_policy);
+		if (arr != NULL && !arr_track(arr, size))
+		{
+			munmap(arr, size);
+			arr = NULL;
+		}
+	}
+	if (arr == NULL)  /* plain policy, small array or failed mapping */
+	{
+		arr = (int *) calloc(length, sizeof(int));
+	}
 	if (arr == NULL)
 	{
 		fprintf(stderr, "Out of memory!");
@@ -19,7 +175,34 @@ int *arr_alloc(int length)
 
 void arr_free(int *arr)
 {
-	free(arr);
+	int k;
+	size_t size = 0;
+
+	if (arr == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&maps_lock);
+	for (k = 0; k < n_maps; k++)
+	{
+		if (maps[k].arr == arr)
+		{
+			size = maps[k].size;
+			maps[k] = maps[--n_maps];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&maps_lock);
+
+	if (size > 0)
+	{
+		munmap(arr, size);
+	}
+	else
+	{
+		free(arr);
+	}
 }
 
 void arr_print(int *arr, int length)
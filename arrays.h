@@ -5,8 +5,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+/* allocation policies of arr_alloc */
+#define ARR_PLAIN 0    /* calloc (default) */
+#define ARR_ALIGNED 1  /* large arrays get their own page-aligned mapping */
+#define ARR_THP 2      /* huge-page-aligned mapping, backed by transparent huge pages */
+#define ARR_HUGETLB 3  /* huge-page-aligned mapping of explicit huge pages (falls back to ARR_THP) */
+
+#define ARR_MAP_MIN (1 << 20)  /* smallest array (bytes) given its own mapping */
+
+/* allocation policy */
+void arr_set_policy(int policy);
+int arr_get_policy(void);
+size_t arr_page_ints(void);
+
 /* functions for 1D case */
-int *arr_alloc(int length);
+int *arr_alloc(size_t length);
 void arr_free(int *arr);
 void arr_print(int *arr, int length);
 
@@ -4,24 +4,215 @@ _automata.pyx
 Wrapping cython code for automata.c code
 """
 
+import warnings
 import cython
 import numpy as np
 cimport numpy as np
 cimport c_automata
+from libc.stdlib cimport malloc, free
+
+_layouts = {
+    'rowmajor': c_automata.LAYOUT_ROWMAJOR,
+    'tiled': c_automata.LAYOUT_TILED,
+    'morton': c_automata.LAYOUT_MORTON,
+}
+
+
+def set_layout(layout):
+    """Choose the storage layout of automata states: 'rowmajor', 'tiled' or 'morton'.
+    
+    Arrays passed to and returned from this module are always row-major numpy
+    arrays, the layout only affects the grids used inside the engine.
+    """
+    if layout not in _layouts:
+        raise ValueError("Layout must be one of %s" % ", ".join(_layouts))
+    c_automata.set_layout(_layouts[layout])
+
+
+_policies = {
+    'plain': c_automata.ARR_PLAIN,
+    'aligned': c_automata.ARR_ALIGNED,
+    'thp': c_automata.ARR_THP,
+    'hugetlb': c_automata.ARR_HUGETLB,
+}
+
+_types = {'N': 0, 'C': 1, 'E': 2, 'D': 3}
+_directions = {'above': c_automata.FP_ABOVE, 'below': c_automata.FP_BELOW}
+
+
+def set_allocator(policy):
+    """Choose how the engine allocates large grids and histograms: 'plain'
+    (calloc, the default), 'aligned' (page-aligned mappings placed on the
+    NUMA node of the thread that first writes them), 'thp' (aligned, with
+    transparent huge pages) or 'hugetlb' (aligned, with reserved huge pages,
+    falling back to 'thp'). Only arrays of at least 1 MB are mapped, so the
+    per-thread grids of a Simulator are page-aligned only under the
+    non-plain policies and when its arena reaches that size.
+    """
+    if policy not in _policies:
+        raise ValueError("Policy must be one of %s" % ", ".join(_policies))
+    c_automata.arr_set_policy(_policies[policy])
+
+
+cdef _check_layout(int N):
+    if not c_automata.layout_supported(c_automata.grid_layout, N):
+        raise ValueError("Current layout does not support N = %d" % N)
+
+
+cdef int[:, :, ::1] _import_states(init, int N):
+    """Copy one (N, N) state or a stack of (k, N, N) states into the grid layout."""
+    _check_layout(N)
+    
+    cdef int[:, :, ::1] states = np.ascontiguousarray(init, dtype='i4').reshape((-1, N, N))
+    cdef int[:, :, ::1] grids = np.zeros((states.shape[0], N, N), dtype='i4')
+    cdef int k
+    for k in range(states.shape[0]):
+        c_automata.layout_import(&grids[k, 0, 0], &states[k, 0, 0], N)
+    return grids
+
+
+cdef int[:, ::1] _thresholds(thresholds):
+    """(type, level, direction) thresholds as rows of a Threshold array
+    (type 'N', 'C', 'E', 'D' or 0 - 3, direction 'above' or 'below')."""
+    cdef int[:, ::1] out = np.zeros((len(thresholds), 3), dtype='i4')
+    cdef int k
+    for k, (kind, level, direction) in enumerate(thresholds):
+        kind = _types.get(kind, kind)
+        if kind not in (0, 1, 2, 3):
+            raise ValueError("Threshold type must be one of N, C, E, D")
+        if direction not in _directions:
+            raise ValueError("Threshold direction must be 'above' or 'below'")
+        out[k, 0] = kind
+        out[k, 1] = level
+        out[k, 2] = _directions[direction]
+    return out
+
+
+cdef c_automata.modelPtr _select_model(engine, alpha, beta) except NULL:
+    """Model function of an engine: 'reference' (model_simple / model_extend),
+    'blocked' (both models, counter-based random numbers), 'bitsliced' or
+    'vector' (simple model only)."""
+    if engine == 'reference':
+        if alpha is None and beta is None:
+            return c_automata.model_simple
+        return c_automata.model_extend
+    if engine == 'blocked':
+        return c_automata.model_blocked
+    
+    if engine not in ('bitsliced', 'vector'):
+        raise ValueError("Unknown engine '%s'" % engine)
+    if not (alpha is None and beta is None):
+        raise ValueError("The %s engine only supports the simple model" % engine)
+    
+    if engine == 'bitsliced':
+        return c_automata.model_bitsliced
+    return c_automata.model_vector
+
 
 @cython.boundscheck(False)
 @cython.wraparound(False)
 def init_state(int N, int m):
+    _check_layout(N)
+    
+    cdef int[:, ::1] arr = np.zeros((N, N), dtype='i4')
+    cdef int[:, ::1] grid = np.zeros((N, N), dtype='i4')
+    c_automata.init_state(&grid[0, 0], N, m)
+    c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
+    return np.asarray(arr)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def init_cluster(int N, int m):
+    """Initial state with a single connected tumour of m cancer cells."""
+    _check_layout(N)
+    
     cdef int[:, ::1] arr = np.zeros((N, N), dtype='i4')
-    c_automata.init_state(&arr[0, 0], N, m)
+    cdef int[:, ::1] grid = np.zeros((N, N), dtype='i4')
+    c_automata.init_cluster(&grid[0, 0], N, m)
+    c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
     return np.asarray(arr)
+
+
+def init_density(int N, density):
+    """Random initial state with fractions density = (N, C, E, D) of each cell type,
+    eg. the stationary densities returned by meanfield()."""
+    if len(density) != 4:
+        raise TypeError("Density must be of length 4")
+    _check_layout(N)
+    
+    cdef double[::1] _density = np.asarray(density, dtype=np.float)
+    cdef int[:, ::1] arr = np.zeros((N, N), dtype='i4')
+    cdef int[:, ::1] grid = np.zeros((N, N), dtype='i4')
+    c_automata.init_density(&grid[0, 0], N, &_density[0])
+    c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
+    return np.asarray(arr)
+
+
+def meanfield(probs, competition=True, alpha=None, beta=None, order='pair', init=(0.9, 0.1, 0.0, 0.0), steps=None, tol=1e-10, max_steps=100000):
+    """Deterministic approximation of the cell type densities (N, C, E, D).
+    
+    order is 'pair' (pair approximation) or 'mean' (mean-field). Returns the
+    stationary densities, or the (steps, 4) densities after each automata step
+    when steps is given.
+    """
+    if len(probs) != 5:
+        raise TypeError("Probability must be of length 5")
+    if len(init) != 4:
+        raise TypeError("Initial density must be of length 4")
+    if order not in ('pair', 'mean'):
+        raise ValueError("Order must be 'pair' or 'mean'")
+    
+    cdef double[5] _probs = np.asarray(probs, dtype=np.float);
+    cdef double[::1] _init = np.asarray(init, dtype=np.float)
+    cdef int _order = c_automata.MF_PAIR if order == 'pair' else c_automata.MF_MEAN_FIELD
+    
+    cdef c_automata.Params params
+    params.probs = _probs
+    params.competition = <int>(competition)
+    params.alpha = 0.0 if alpha is None else <double>alpha
+    params.beta = 0.0 if beta is None else <double>beta
+    
+    cdef double[:, ::1] trajectory
+    cdef double[::1] density
+    if steps is not None:
+        trajectory = np.zeros((steps, 4), np.float)
+        c_automata.meanfield_trajectory(&trajectory[0, 0], &_init[0], _order, params, steps)
+        return np.asarray(trajectory)
+    
+    density = np.zeros(4, np.float)
+    if c_automata.meanfield_stationary(&density[0], &_init[0], _order, params, tol, max_steps) < 0:
+        warnings.warn("Mean-field solution not stationary after %d steps" % max_steps, RuntimeWarning)
+    return np.asarray(density)
+
+
+def load_state(int N, path):
+    """Read an N x N state written by save_state (or arr2_print)."""
+    _check_layout(N)
+    
+    cdef int[:, ::1] arr = np.zeros((N, N), dtype='i4')
+    cdef int[:, ::1] grid = np.zeros((N, N), dtype='i4')
+    cdef bytes _path = path.encode()
+    if c_automata.state_load(&grid[0, 0], N, _path) != 0:
+        raise IOError("Could not read a %d x %d state from '%s'" % (N, N, path))
+    c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
+    return np.asarray(arr)
+
+
+def save_state(arr, path):
+    """Write a state to a text file readable by load_state."""
+    cdef int[:, ::1] grid = _import_states(arr, np.shape(arr)[0])[0]
+    cdef bytes _path = path.encode()
+    if c_automata.state_save(&grid[0, 0], grid.shape[0], _path) != 0:
+        raise IOError("Could not write state to '%s'" % path)
 	
 
 @cython.boundscheck(False)
 @cython.wraparound(False)
-def pdf(int N, int c_cells, int steps, int runs, probs, competition=True, alpha=None, beta=None):
+def pdf(int N, int c_cells, int steps, int runs, probs, competition=True, alpha=None, beta=None, engine='reference', init=None):
     if len(probs) != 5:
         raise TypeError("Probability must be of length 5")
+    _check_layout(N)
     
     cdef double[5] _probs = np.asarray(probs, dtype=np.float);
     cdef double[::1] output = np.zeros(N ** 2, np.float)
@@ -32,22 +223,73 @@ def pdf(int N, int c_cells, int steps, int runs, probs, competition=True, alpha=
     params.alpha = 0.0 if alpha is None else <double>alpha
     params.beta = 0.0 if beta is None else <double>beta
     
-    cdef c_automata.modelPtr model
-    if alpha is None and beta is None:
-        model = c_automata.model_simple
-    else:
-        model = c_automata.model_extend
+    cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
     
-    c_automata.pdf(&output[0], N, c_cells, steps, runs, model, params)
+    # runs start from copies of the pre-built states in init (c_cells is ignored)
+    # runs of the bitsliced engine stay packed from start to end
+    cdef int[:, :, ::1] grids
+    if init is None and engine == 'bitsliced':
+        c_automata.pdf_bitsliced(&output[0], N, c_cells, steps, runs, params)
+    elif init is None:
+        c_automata.pdf(&output[0], N, c_cells, steps, runs, model, params)
+    else:
+        grids = _import_states(init, N)
+        c_automata.pdf_init(&output[0], N, &grids[0, 0, 0], grids.shape[0], steps, runs, model, params)
     
     return np.asarray(output)
 
 
 @cython.boundscheck(False)
 @cython.wraparound(False)
-def pdf_rolling(int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, probs, competition=True, alpha=None, beta=None):
+def pdf_splitting(int N, int c_cells, int steps, int runs, probs, levels, int split=2, upper=True, competition=True, alpha=None, beta=None, engine='reference'):
+    """pdf of the final number of cancer cells estimated with multilevel splitting.
+    
+    Runs are cloned 'split' times each time their cancer count crosses one of
+    the levels towards the tail (increasing levels with upper=True, decreasing
+    with upper=False). Returns the weighted pdf (length N ** 2 + 1) and the
+    number of runs simulated.
+    """
     if len(probs) != 5:
         raise TypeError("Probability must be of length 5")
+    if split < 2:
+        raise ValueError("Split must be at least 2")
+    _check_layout(N)
+    
+    cdef int[::1] _levels = np.ascontiguousarray(levels, dtype='i4')
+    if np.any(np.diff(_levels) <= 0 if upper else np.diff(_levels) >= 0):
+        raise ValueError("Levels must be strictly monotonic towards the tail")
+    
+    cdef double[5] _probs = np.asarray(probs, dtype=np.float);
+    cdef double[::1] output = np.zeros(N ** 2 + 1, np.float)
+    
+    cdef c_automata.Params params
+    params.probs = _probs
+    params.competition = <int>(competition)
+    params.alpha = 0.0 if alpha is None else <double>alpha
+    params.beta = 0.0 if beta is None else <double>beta
+    
+    cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
+    
+    cdef int dummy = 0
+    cdef long simulated = c_automata.pdf_splitting(&output[0], N, c_cells, steps, runs, model, params,
+                                                   &_levels[0] if _levels.shape[0] > 0 else &dummy, _levels.shape[0], split, <int>(upper))
+    
+    return np.asarray(output), simulated
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def pdf_rolling(int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, probs, competition=True, alpha=None, beta=None, engine='reference', init=None, clusters=False):
+    """pdf of the number of cancer cells in the stationary state.
+    
+    With clusters=True also returns the pdf of tumour (cluster) sizes and the
+    pdf of the number of tumours per sample, both of length N ** 2 + 1.
+    """
+    if len(probs) != 5:
+        raise TypeError("Probability must be of length 5")
+    if clusters and init is not None:
+        raise ValueError("Cluster statistics are not supported with pre-built initial states")
+    _check_layout(N)
     
     #cdef int comp = 1 if competition else 0
     
@@ -60,20 +302,37 @@ def pdf_rolling(int N, int c_cells, int init_steps, int samples, int sample_gap,
     params.alpha = 0.0 if alpha is None else <double>alpha
     params.beta = 0.0 if beta is None else <double>beta
     
-    cdef c_automata.modelPtr model
-    if alpha is None and beta is None:
-        model = c_automata.model_simple
-    else:
-        model = c_automata.model_extend
+    cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
         
-    c_automata.pdf_rolling(&output[0], N, c_cells, init_steps, samples, sample_gap, runs, model, params)
+    cdef int[:, :, ::1] grids
+    cdef double[::1] size_pdf, number_pdf
+    if clusters:
+        size_pdf = np.zeros(N ** 2 + 1, np.float)
+        number_pdf = np.zeros(N ** 2 + 1, np.float)
+        c_automata.pdf_rolling_clusters(&output[0], &size_pdf[0], &number_pdf[0], N, c_cells, init_steps, samples, sample_gap, runs, model, params)
+        return np.asarray(output), np.asarray(size_pdf), np.asarray(number_pdf)
+    elif init is None and engine == 'bitsliced':
+        c_automata.pdf_rolling_bitsliced(&output[0], N, c_cells, init_steps, samples, sample_gap, runs, params)
+    elif init is None:
+        c_automata.pdf_rolling(&output[0], N, c_cells, init_steps, samples, sample_gap, runs, model, params)
+    else:
+        grids = _import_states(init, N)
+        c_automata.pdf_rolling_init(&output[0], N, &grids[0, 0, 0], grids.shape[0], init_steps, samples, sample_gap, runs, model, params)
     
     return np.asarray(output)
     
 
 @cython.boundscheck(False)
 @cython.wraparound(False)
-def iterate(int[:, ::1] arr not None, int steps, probs, competition=True, alpha=None, beta=None):
+def iterate(int[:, ::1] arr not None, int steps, probs, competition=True, alpha=None, beta=None, engine='reference', clusters=False, int block=0):
+    """Advance arr in place, returns the (steps, 4) cell type counts.
+    
+    With engine='blocked', 'block' steps are run per pass over the grid
+    (0 to size the block to the cache), the results do not depend on it.
+    
+    With clusters=True also returns the number of tumours after each step and
+    the histogram of tumour sizes over all steps (length N ** 2 + 1).
+    """
     if len(probs) != 5:
         raise TypeError("Probability must be of length 5")
     
@@ -86,12 +345,183 @@ def iterate(int[:, ::1] arr not None, int steps, probs, competition=True, alpha=
     params.alpha = 0.0 if alpha is None else <double>alpha
     params.beta = 0.0 if beta is None else <double>beta
     
-    cdef c_automata.modelPtr model
-    if alpha is None and beta is None:
-        model = c_automata.model_simple
-    else:
-        model = c_automata.model_extend
+    cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
             
-    c_automata.iterate(&arr[0, 0], arr.shape[0], steps, model, params, &out_counts[0, 0])
+    cdef int N = arr.shape[0]
+    _check_layout(N)
+    
+    cdef int[:, ::1] grid = arr
+    if c_automata.grid_layout != c_automata.LAYOUT_ROWMAJOR:
+        grid = np.zeros((N, N), dtype='i4')
+        c_automata.layout_import(&grid[0, 0], &arr[0, 0], N)
+    
+    cdef int[::1] out_clusters, size_hist
+    if clusters:
+        out_clusters = np.zeros(steps, dtype='i4')
+        size_hist = np.zeros(N ** 2 + 1, dtype='i4')
+        c_automata.iterate_clusters(&grid[0, 0], N, steps, model, params, &out_counts[0, 0], &out_clusters[0], &size_hist[0])
+    elif engine == 'bitsliced':
+        c_automata.iterate_bitsliced(&grid[0, 0], N, steps, params, &out_counts[0, 0])
+    elif engine == 'blocked':
+        if block < 0:
+            raise ValueError("Block must be non-negative")
+        c_automata.iterate_blocked(&grid[0, 0], N, steps, block, params, &out_counts[0, 0])
+    else:
+        c_automata.iterate(&grid[0, 0], N, steps, model, params, &out_counts[0, 0])
+    
+    if c_automata.grid_layout != c_automata.LAYOUT_ROWMAJOR:
+        c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
     
+    if clusters:
+        return np.asarray(out_counts), np.asarray(out_clusters), np.asarray(size_hist)
     return np.asarray(out_counts)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def coupled(int N, int c_cells, int steps, int runs, probs, competition=True, alpha=None, beta=None):
+    """Final cell type counts of coupled replicas, one per parameter set.
+    
+    probs is an (n, 5) array with one row per replica. competition, alpha and
+    beta are scalars or length-n sequences. The replicas of a run start from
+    the same initial state and share all random numbers, so differences
+    between replicas (eg. counts[:, 1, 1] - counts[:, 0, 1] for a change of
+    k1) have far lower variance than between independent runs.
+    Returns the (runs, n, 4) counts.
+    """
+    _probs = np.atleast_2d(np.asarray(probs, dtype=np.float))
+    if _probs.shape[1] != 5:
+        raise TypeError("Probability must be of length 5")
+    _check_layout(N)
+    cdef int n = _probs.shape[0], v
+    _competition = np.broadcast_to(np.asarray(competition), (n,))
+    _alpha = np.broadcast_to(np.asarray(0.0 if alpha is None else alpha, dtype=np.float), (n,))
+    _beta = np.broadcast_to(np.asarray(0.0 if beta is None else beta, dtype=np.float), (n,))
+    
+    cdef int k
+    cdef int[:, :, ::1] output = np.zeros((runs, n, 4), dtype='i4')
+    cdef c_automata.Params *params = <c_automata.Params *> malloc(n * sizeof(c_automata.Params))
+    if params == NULL:
+        raise MemoryError()
+    try:
+        for v in range(n):
+            for k in range(5):
+                params[v].probs[k] = _probs[v, k]
+            params[v].competition = <int>(_competition[v])
+            params[v].alpha = _alpha[v]
+            params[v].beta = _beta[v]
+        c_automata.endcount_coupled(&output[0, 0, 0], n, N, c_cells, steps, runs, params)
+    finally:
+        free(params)
+    return np.asarray(output)
+
+
+cdef class Simulator:
+    """Persistent simulator for automata of side length N.
+    
+    Keeps work grids, histograms, random number streams and 'threads' worker
+    threads alive between calls, for sweeps calling pdf / pdf_rolling /
+    iterate many times with different parameters. Runs are split over the
+    workers (worker k is seeded with seed + k).
+    """
+    cdef c_automata.Simulator *_sim
+    cdef readonly int N
+    cdef readonly int threads
+    
+    def __cinit__(self, int N, int threads=1, seed=None):
+        if N < 1 or threads < 1:
+            raise ValueError("N and threads must be positive")
+        _check_layout(N)
+        self.N = N
+        self.threads = threads
+        self._sim = c_automata.sim_alloc(N, threads, -1 if seed is None else <long>seed)
+    
+    def __dealloc__(self):
+        if self._sim != NULL:
+            c_automata.sim_free(self._sim)
+    
+    def seed(self, long seed):
+        c_automata.sim_seed(self._sim, seed)
+    
+    cdef c_automata.Params _params(self, probs, competition, alpha, beta) except *:
+        if len(probs) != 5:
+            raise TypeError("Probability must be of length 5")
+        _check_layout(self.N)
+        
+        cdef c_automata.Params params
+        cdef double[5] _probs = np.asarray(probs, dtype=np.float);
+        params.probs = _probs
+        params.competition = <int>(competition)
+        params.alpha = 0.0 if alpha is None else <double>alpha
+        params.beta = 0.0 if beta is None else <double>beta
+        return params
+    
+    def pdf(self, int c_cells, int steps, int runs, probs, competition=True, alpha=None, beta=None, engine='reference'):
+        cdef c_automata.Params params = self._params(probs, competition, alpha, beta)
+        cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
+        cdef double[::1] output = np.zeros(self.N ** 2 + 1, np.float)
+        
+        with nogil:
+            c_automata.sim_pdf(self._sim, &output[0], c_cells, steps, runs, model, params)
+        return np.asarray(output)
+    
+    def pdf_rolling(self, int c_cells, int init_steps, int samples, int sample_gap, int runs, probs, competition=True, alpha=None, beta=None, engine='reference'):
+        cdef c_automata.Params params = self._params(probs, competition, alpha, beta)
+        cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
+        cdef double[::1] output = np.zeros(self.N ** 2 + 1, np.float)
+        
+        with nogil:
+            c_automata.sim_pdf_rolling(self._sim, &output[0], c_cells, init_steps, samples, sample_gap, runs, model, params)
+        return np.asarray(output)
+    
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def iterate(self, int[:, ::1] arr not None, int steps, probs, competition=True, alpha=None, beta=None, engine='reference'):
+        """Advance arr in place, returns the (steps, 4) cell type counts."""
+        if arr.shape[0] != self.N or arr.shape[1] != self.N:
+            raise ValueError("State must be of shape (%d, %d)" % (self.N, self.N))
+        cdef c_automata.Params params = self._params(probs, competition, alpha, beta)
+        cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
+        cdef int[:, ::1] out_counts = np.zeros((steps, 4), dtype='i4')
+        
+        cdef int N = self.N
+        cdef int[:, ::1] grid = arr
+        if c_automata.grid_layout != c_automata.LAYOUT_ROWMAJOR:
+            grid = np.zeros((N, N), dtype='i4')
+            c_automata.layout_import(&grid[0, 0], &arr[0, 0], N)
+        
+        with nogil:
+            c_automata.sim_iterate(self._sim, &grid[0, 0], steps, model, params, &out_counts[0, 0])
+        
+        if c_automata.grid_layout != c_automata.LAYOUT_ROWMAJOR:
+            c_automata.layout_export(&arr[0, 0], &grid[0, 0], N)
+        return np.asarray(out_counts)
+    
+    def first_passage(self, int c_cells, int max_steps, int runs, thresholds, probs, competition=True, alpha=None, beta=None, engine='reference'):
+        """Histograms of the first-passage times of cell count thresholds.
+        
+        thresholds is a list of (type, level, direction), eg. ('C', 0, 'below')
+        for tumour extinction. Returns the (len(thresholds), max_steps + 2)
+        histograms of the step at which each threshold was first met (column
+        max_steps + 1 counts the runs that never met it) and the number of
+        steps simulated (runs stop once all thresholds have been met).
+        """
+        cdef c_automata.Params params = self._params(probs, competition, alpha, beta)
+        cdef c_automata.modelPtr model = _select_model(engine, alpha, beta)
+        cdef int[:, ::1] th = _thresholds(thresholds)
+        cdef int n = th.shape[0]
+        if n == 0 or n > self.N ** 2 + 1:
+            raise ValueError("Between 1 and N ** 2 + 1 thresholds are supported")
+        cdef int[:, ::1] hist = np.zeros((n, max_steps + 2), dtype='i4')
+        cdef long simulated
+        
+        # rows of th have the memory layout of Threshold {type, level, direction}
+        with nogil:
+            simulated = c_automata.sim_first_passage(self._sim, &hist[0, 0], c_cells, max_steps, runs, model, params,
+                                                     <c_automata.Threshold *> &th[0, 0], n)
+        return np.asarray(hist), simulated
+
+
+def first_passage(int N, int c_cells, int max_steps, int runs, thresholds, probs, competition=True, alpha=None, beta=None, engine='reference', threads=1, seed=None):
+    """First-passage time histograms over runs, see Simulator.first_passage."""
+    return Simulator(N, threads, seed).first_passage(c_cells, max_steps, runs, thresholds, probs, competition, alpha, beta, engine)
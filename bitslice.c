@@ -0,0 +1,687 @@
+/*
+ Bit-sliced version of model_simple
+
+ Cell states are encoded in two bitplanes (hi, lo):
+	N -> 00, C -> 01, E -> 10, D -> 11
+ and T_CANCER_TEMP cells in a third plane (inv, with hi = lo = 0). Rows are
+ padded to a whole number of 64-bit words, the padding bits are always
+ zero. Every probability is turned into a packed Bernoulli mask, so a word
+ of 64 cells costs a handful of random words instead of 64 calls to
+ gsl_rng_uniform.
+
+ The rows are swept in the order of model_simple, which updates in place :
+ a cancer cell sees the cells above and to its left already updated and
+ the cells below and to its right as they were. Across a row everything is
+ known up front except whether the left neighbour of a cancer cell was
+ invaded by the cancer cell before it, which only happens along runs of
+ C N C N ... cells. Each word is therefore evaluated under both answers
+ for the cells of such runs, and the run is resolved with a few shifts
+ (see bitgrid_step). The law of the engine is that of model_simple
+ (checked by test_conformance), only the random numbers differ.
+ */
+
+#include <stdlib.h>
+#include "bitslice.h"
+
+#define ROW(g, plane, i) (&(g)->plane[(size_t) (i) * (g)->words])
+
+#define P_ALWAYS (1ULL << 32)  /* threshold of a probability >= 1 */
+
+/* cached grid used by model_bitsliced (one per thread) */
+static __thread Bitgrid *bs_cache = NULL;
+
+
+/* ------------------------------------------------------------------------------------- */
+/* random bits */
+/* ------------------------------------------------------------------------------------- */
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/* xoshiro256** generator, one 64-bit word of random bits per call */
+static inline uint64_t bits_next(uint64_t *s)
+{
+	uint64_t out = rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return out;
+}
+
+/* seed the bit generator from the gsl generator */
+static void bits_seed(uint64_t *s)
+{
+	int k;
+	uint64_t z = ((uint64_t) gsl_rng_get(rng) << 32) ^ (uint64_t) gsl_rng_get(rng);
+
+	/* splitmix64 expansion of the seed */
+	for (k = 0; k < 4; k++)
+	{
+		z += 0x9E3779B97F4A7C15ULL;
+		s[k] = z;
+		s[k] = (s[k] ^ (s[k] >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		s[k] = (s[k] ^ (s[k] >> 27)) * 0x94D049BB133111EBULL;
+		s[k] = s[k] ^ (s[k] >> 31);
+	}
+}
+
+/* Bernoulli trials with a probability per class of lanes */
+typedef struct {
+	uint64_t always[5];  /* all ones for the classes with probability >= 1 */
+	uint64_t live[5];    /* all ones for the classes with 0 < probability < 1 */
+	uint64_t bit[32][5]; /* bit[k][c] : all ones if bit k of the threshold of class c is set */
+} Trials;
+
+/* thresholds of the classes (32 bit fixed point, u < t <=> r < p for u = r 2^32) */
+static void trials_set(Trials *tr, const double *p, int n)
+{
+	int c, k;
+	uint64_t t;
+
+	for (c = 0; c < n; c++)
+	{
+		t = (p[c] <= 0.0) ? 0 : (p[c] >= 1.0) ? P_ALWAYS : (uint64_t) ceil(p[c] * 4294967296.0);
+		tr->always[c] = (t >= P_ALWAYS) ? ~0ULL : 0;
+		tr->live[c] = (t > 0 && t < P_ALWAYS) ? ~0ULL : 0;
+		for (k = 0; k < 32; k++)
+		{
+			tr->bit[k][c] = 0 - ((t >> k) & 1);
+		}
+	}
+}
+
+/*
+bern_lanes : packed Bernoulli trials, bit b of the result is set with the
+			 probability of class c for every bit b set in lanes[c]
+			 (the lane masks must not overlap)
+
+Each lane compares a random binary fraction against its own threshold from
+the most significant bit down. A lane is decided at the first bit where
+the two differ, so about log2(number of lanes) + 2 random words are used.
+*/
+static inline uint64_t bern_lanes(uint64_t *s, const uint64_t *lanes, int n, const Trials *tr)
+{
+	int c, k;
+	uint64_t r, tb, active = 0, out = 0;
+
+	for (c = 0; c < n; c++)
+	{
+		out |= lanes[c] & tr->always[c];
+		active |= lanes[c] & tr->live[c];
+	}
+
+	for (k = 31; k >= 0 && active != 0; k--)
+	{
+		r = bits_next(s);
+		tb = 0;
+		for (c = 0; c < n; c++)
+		{
+			tb |= lanes[c] & tr->bit[k][c];
+		}
+		out |= active & tb & ~r;  /* random bit 0 < threshold bit 1 : u < t */
+		active &= ~(tb ^ r);      /* undecided while the bits agree */
+	}
+	return out;
+}
+
+/* number of bits set (without relying on a popcount instruction) */
+static inline int popcount64(uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int) ((x * 0x0101010101010101ULL) >> 56);
+}
+
+/* split the lanes by how many of a, b, c, d they have set (eq[k] : k set) */
+static inline void count_lanes(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t *eq)
+{
+	uint64_t x = a ^ b, xa = a & b;
+	uint64_t y = c ^ d, yc = c & d;
+	uint64_t s0 = x ^ y, carry = x & y;
+	uint64_t s1 = xa ^ yc ^ carry;
+	uint64_t s2 = (xa & yc) | (xa & carry) | (yc & carry);
+
+	eq[0] = ~s2 & ~s1 & ~s0;
+	eq[1] = ~s2 & ~s1 & s0;
+	eq[2] = ~s2 & s1 & ~s0;
+	eq[3] = ~s2 & s1 & s0;
+	eq[4] = s2;
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* bit grid handling */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+bitgrid_alloc : allocate a bit-sliced automata of side length N
+				(all cells normal)
+*/
+Bitgrid *bitgrid_alloc(int N)
+{
+	Bitgrid *g;
+	size_t len;
+
+	g = (Bitgrid *) calloc(1, sizeof(Bitgrid));
+	if (g == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	g->N = N;
+	g->words = (N + 63) / 64;
+	g->tail = (N % 64 == 0) ? ~0ULL : ((1ULL << (N % 64)) - 1);
+
+	len = (size_t) N * g->words;
+	g->lo = (uint64_t *) calloc(len, sizeof(uint64_t));
+	g->hi = (uint64_t *) calloc(len, sizeof(uint64_t));
+	g->inv = (uint64_t *) calloc(len, sizeof(uint64_t));
+	if (g->lo == NULL || g->hi == NULL || g->inv == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+	return g;
+}
+
+void bitgrid_free(Bitgrid *g)
+{
+	if (g == NULL)
+	{
+		return;
+	}
+	free(g->lo);
+	free(g->hi);
+	free(g->inv);
+	free(g);
+}
+
+/*
+bitgrid_pack : load an automata state (integer array of length N x N, stored
+			   in grid_layout) into the bitplanes and reseed the bit generator from the gsl rng
+			   (the gsl rng must be initialized)
+*/
+void bitgrid_pack(Bitgrid *g, int *array)
+{
+	int i, j, w, b, n, v, N = g->N;
+	int *row;
+	uint64_t lo, hi;
+
+	for (i = 0; i < N; i++)
+	{
+		row = &array[(size_t) N * i];
+		for (w = 0; w < g->words; w++)
+		{
+			n = (N - 64 * w < 64) ? N - 64 * w : 64;
+			lo = hi = 0;
+			for (b = 0; b < n; b++)
+			{
+				j = 64 * w + b;
+				v = (grid_layout == LAYOUT_ROWMAJOR) ? row[j] : array[grid_index(N, i, j)];
+				lo |= (uint64_t) (v & 1) << b;
+				hi |= (uint64_t) ((v >> 1) & 1) << b;
+			}
+			ROW(g, lo, i)[w] = lo;
+			ROW(g, hi, i)[w] = hi;
+			ROW(g, inv, i)[w] = 0;
+		}
+	}
+
+	bits_seed(g->s);
+}
+
+/*
+bitgrid_unpack : write the bitplanes back to an automata state
+				 (integer array of length N x N)
+*/
+void bitgrid_unpack(Bitgrid *g, int *array)
+{
+	int i, j, N = g->N;
+	int *row;
+	uint64_t *lo, *hi;
+
+	for (i = 0; i < N; i++)
+	{
+		lo = ROW(g, lo, i);
+		hi = ROW(g, hi, i);
+		if (grid_layout == LAYOUT_ROWMAJOR)
+		{
+			row = &array[(size_t) N * i];
+			for (j = 0; j < N; j++)
+			{
+				row[j] = (int) ((lo[j >> 6] >> (j & 63)) & 1) | (int) (((hi[j >> 6] >> (j & 63)) & 1) << 1);
+			}
+			continue;
+		}
+		for (j = 0; j < N; j++)
+		{
+			array[grid_index(N, i, j)] = (int) ((lo[j >> 6] >> (j & 63)) & 1)
+							 | (int) (((hi[j >> 6] >> (j & 63)) & 1) << 1);
+		}
+	}
+}
+
+/*
+bitgrid_count : identical to type_count for a bit-sliced automata
+*/
+void bitgrid_count(Bitgrid *g, int *output)
+{
+	size_t id, len = (size_t) g->N * g->words;
+	long c = 0, e = 0, d = 0;
+
+	for (id = 0; id < len; id++)
+	{
+		c += popcount64(g->lo[id] & ~g->hi[id]);
+		e += popcount64(g->hi[id] & ~g->lo[id]);
+		d += popcount64(g->hi[id] & g->lo[id]);
+	}
+
+	output[0] = g->N * g->N - (int) (c + e + d);
+	output[1] = (int) c;
+	output[2] = (int) e;
+	output[3] = (int) d;
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* bit-sliced iteration functions */
+/* ------------------------------------------------------------------------------------- */
+
+/* normal and cancer masks of a word (valid : cells inside the automata) */
+static inline uint64_t normal_mask(uint64_t lo, uint64_t hi, uint64_t inv, uint64_t valid)
+{
+	return ~(lo | hi | inv) & valid;
+}
+
+static inline uint64_t cancer_mask(uint64_t lo, uint64_t hi)
+{
+	return lo & ~hi;
+}
+
+/* neighbour masks : bit b holds the value of the cell to the right / left of cell b */
+static inline uint64_t shift_right(uint64_t x, uint64_t next)
+{
+	return (x >> 1) | (next << 63);
+}
+
+static inline uint64_t shift_left(uint64_t x, uint64_t prev)
+{
+	return (x << 1) | (prev >> 63);
+}
+
+/*
+proliferation : proliferation of the cancer lanes of a word given the
+				normal (n*) and cancer (c*) masks of the right, down, up
+				and left neighbours
+
+returns :
+	prolif : lanes that proliferate
+	right  : lanes that invade their right neighbour
+*/
+static void proliferation(uint64_t *s, uint64_t cancer, uint64_t nr, uint64_t nd, uint64_t nu, uint64_t nl,
+						  uint64_t cr, uint64_t cd, uint64_t cu, uint64_t cl, int competition,
+						  const Trials *t_prolif, const Trials *t_right, uint64_t *prolif, uint64_t *right)
+{
+	int k;
+	uint64_t eq_n[5], eq_c[5], lanes[5];
+
+	count_lanes(nr, nd, nu, nl, eq_n);
+	cancer &= ~eq_n[0]; /* no normal neighbour : nothing to invade */
+
+	/* k1_prime = k1 * (1 - neigh_c / 4) */
+	if (competition)
+	{
+		count_lanes(cr, cd, cu, cl, eq_c);
+		for (k = 0; k < 5; k++)
+		{
+			lanes[k] = cancer & eq_c[k];
+		}
+		*prolif = bern_lanes(s, lanes, 5, t_prolif);
+	}
+	else
+	{
+		*prolif = bern_lanes(s, &cancer, 1, t_prolif);
+	}
+
+	/* the right neighbour is the first of the neigh_n candidates (order of order_neighbours) */
+	for (k = 1; k < 5; k++)
+	{
+		lanes[k - 1] = *prolif & nr & eq_n[k];
+	}
+	*right = bern_lanes(s, lanes, 4, t_right);
+}
+
+/*
+invade : proliferation of the lanes of a word into one of their normal
+		 down, left or up neighbours (nd, nl, nu), chosen uniformly at random
+
+returns :
+	down, left, up : lanes that invade their down, left or up neighbour
+*/
+static inline void invade(uint64_t *s, uint64_t lanes, uint64_t nd, uint64_t nl, uint64_t nu, const Trials *t_pick,
+						  uint64_t *down, uint64_t *left, uint64_t *up)
+{
+	uint64_t d = lanes & nd, l = lanes & nl, u = lanes & nu;
+	uint64_t odd = d ^ l ^ u, two = (d & l) | (d & u) | (l & u);
+	uint64_t pick[3];
+
+	/* down out of 1, 2 or 3 candidates, then left out of the 1 or 2 left */
+	pick[0] = d & odd & ~two;
+	pick[1] = d & two & ~odd;
+	pick[2] = d & odd & two;
+	*down = bern_lanes(s, pick, 3, t_pick);
+
+	l &= ~*down;
+	u &= ~*down;
+	pick[0] = l & ~u;
+	pick[1] = l & u;
+	*left = bern_lanes(s, pick, 2, t_pick);
+	*up = u & ~*left;
+}
+
+/*
+bitgrid_step : apply the model_simple rules to a bit-sliced automata
+
+params **
+	prob  : transition probabilities {k0, k1, k2, k3, k4} of
+			automata states.
+	competition : cancer cells compete for resources
+
+Notes :
+	For a cancer lane the left neighbour is seen after its own update, and
+	is T_CANCER_TEMP if the cancer cell to its left invaded it. The
+	proliferation of a word is drawn both assuming no left neighbour was
+	invaded (*0) and, for the lanes where it could have been (ambiguous),
+	assuming it was (*1). inv[j + 1] = (inv[j - 1] ? right1 : right0)[j]
+	is then solved by iterating from inv = right0 << 1, each pass fixing
+	two more cells of the longest C N C N ... run in the word.
+*/
+void bitgrid_step(Bitgrid *g, Params params)
+{
+	int i, w, k, N = g->N, W = g->words;
+	double *probs = params.probs;
+	double p[5];
+	Trials t_state, t_prolif, t_right, t_pick;
+	uint64_t lanes[4];
+	uint64_t valid, lo, hi, above, nold, c, e, d, hit, mut, eff, die, reb, cnew, nnew;
+	uint64_t nr, nd, nu, nl, cr, cd, cu, cl, old_l, amb, prolif0, right0, prolif1, right1;
+	uint64_t invaded, has_left, x, next, prolif, down, left, up;
+	uint64_t p_c, p_cnew, p_nnew, p_nold, p_inv, p_x; /* bits 62, 63 of the previous word */
+	uint64_t *lo_r, *hi_r, *inv_r, *lo_u, *hi_u, *inv_u, *lo_d, *hi_d, *inv_d, m_u, m_d;
+
+	/* thresholds of N -> C, C -> E, E -> D, D -> N */
+	p[0] = probs[0];
+	p[1] = probs[2];
+	p[2] = probs[3];
+	p[3] = probs[4];
+	trials_set(&t_state, p, 4);
+
+	/* k1, or k1 * (1 - neigh_c / 4) by number of cancer neighbours */
+	for (k = 0; k < 5; k++)
+	{
+		p[k] = probs[1] * (1 - ((double) k) / 4.00);
+	}
+	trials_set(&t_prolif, p, 5);
+
+	/* right neighbour chosen out of 1 to 4 normal neighbours */
+	for (k = 1; k < 5; k++)
+	{
+		p[k - 1] = 1.0 / k;
+	}
+	trials_set(&t_right, p, 4);
+	trials_set(&t_pick, p, 3); /* 1, 1/2, 1/3 */
+
+	for (i = 0; i < N; i++)
+	{
+		p_c = p_cnew = p_nnew = p_nold = p_inv = p_x = 0;
+
+		/* rows i - 1, i, i + 1 (outside of the automata : row i with an empty mask) */
+		lo_r = ROW(g, lo, i);
+		hi_r = ROW(g, hi, i);
+		inv_r = ROW(g, inv, i);
+		lo_u = (i > 0) ? ROW(g, lo, i - 1) : lo_r;
+		hi_u = (i > 0) ? ROW(g, hi, i - 1) : hi_r;
+		inv_u = (i > 0) ? ROW(g, inv, i - 1) : inv_r;
+		lo_d = (i < N - 1) ? ROW(g, lo, i + 1) : lo_r;
+		hi_d = (i < N - 1) ? ROW(g, hi, i + 1) : hi_r;
+		inv_d = (i < N - 1) ? ROW(g, inv, i + 1) : inv_r;
+		m_u = (i > 0) ? ~0ULL : 0;
+		m_d = (i < N - 1) ? ~0ULL : 0;
+
+		for (w = 0; w < W; w++)
+		{
+			valid = (w == W - 1) ? g->tail : ~0ULL;
+			lo = lo_r[w];
+			hi = hi_r[w];
+			above = inv_r[w]; /* invaded by the row above */
+
+			nold = normal_mask(lo, hi, above, valid);
+			c = lo & ~hi;
+			e = hi & ~lo;
+			d = hi & lo;
+
+			/* state transitions (T_CANCER_TEMP lanes have no threshold) */
+			lanes[0] = nold;
+			lanes[1] = c;
+			lanes[2] = e;
+			lanes[3] = d;
+			hit = bern_lanes(g->s, lanes, 4, &t_state);
+			mut = nold & hit; /* N -> C :: MUTATION */
+			eff = c & hit;    /* C -> E :: EFFECTION */
+			die = e & hit;    /* E -> D :: DEATH */
+			reb = d & hit;    /* D -> N :: REBIRTH */
+
+			/* states after the update, unless invaded from the left */
+			cnew = (c & ~eff) | mut;
+			nnew = (nold & ~mut) | reb;
+
+			/* neighbours : right and down before the update, up after it */
+			if (w < W - 1)
+			{
+				nr = shift_right(nold, normal_mask(lo_r[w + 1], hi_r[w + 1], inv_r[w + 1], (w + 1 == W - 1) ? g->tail : ~0ULL));
+				cr = shift_right(c, cancer_mask(lo_r[w + 1], hi_r[w + 1]));
+			}
+			else
+			{
+				nr = nold >> 1;
+				cr = c >> 1;
+			}
+			nd = normal_mask(lo_d[w], hi_d[w], inv_d[w], valid & m_d);
+			cd = cancer_mask(lo_d[w], hi_d[w]) & m_d;
+			nu = normal_mask(lo_u[w], hi_u[w], inv_u[w], valid & m_u);
+			cu = cancer_mask(lo_u[w], hi_u[w]) & m_u;
+
+			/* left after the update, or T_CANCER_TEMP if invaded by the cell before it */
+			nl = shift_left(nnew, p_nnew);
+			cl = shift_left(cnew, p_cnew);
+			old_l = shift_left(nold, p_nold);
+			amb = c & old_l & ((c << 2) | (p_c >> 62)); /* C N C */
+
+			proliferation(g->s, c, nr, nd, nu, nl, cr, cd, cu, cl, params.competition,
+						  &t_prolif, &t_right, &prolif0, &right0);
+			prolif1 = right1 = 0;
+			if (amb)
+			{
+				proliferation(g->s, amb, nr, nd, nu, nl & ~old_l, cr, cd, cu, cl & ~old_l, params.competition,
+							  &t_prolif, &t_right, &prolif1, &right1);
+			}
+
+			/* resolve the runs of cells invaded from the left */
+			invaded = shift_left(right0, p_x);
+			while (1)
+			{
+				has_left = shift_left(invaded, p_inv);
+				x = (right0 & ~has_left) | (right1 & has_left);
+				next = shift_left(x, p_x);
+				if (next == invaded)
+				{
+					break;
+				}
+				invaded = next;
+			}
+			prolif = (prolif0 & ~has_left) | (prolif1 & has_left);
+
+			/* proliferation into the down, left or up neighbour */
+			invade(g->s, prolif & ~x, nd, nl & ~has_left, nu, &t_pick, &down, &left, &up);
+			inv_d[w] |= down;
+			inv_u[w] |= up;
+			if (left & 1)
+			{
+				inv_r[w - 1] |= 1ULL << 63;
+			}
+
+			mut &= ~invaded;
+			lo_r[w] = mut | (c & ~eff) | (e & die) | (d & ~reb);
+			hi_r[w] = (c & eff) | e | (d & ~reb);
+			inv_r[w] = above | invaded | (left >> 1);
+
+			p_cnew = cnew;
+			p_nnew = nnew;
+			p_c = c;
+			p_nold = nold;
+			p_inv = invaded;
+			p_x = x;
+		}
+	}
+
+	/* T_CANCER_TEMP -> T_CANCER */
+	for (w = 0; w < N * W; w++)
+	{
+		g->lo[w] |= g->inv[w];
+		g->inv[w] = 0;
+	}
+}
+
+/*
+model_bitsliced : model_simple rules applied through the bit-sliced engine,
+				  usable wherever a modelPtr is expected
+
+The state is packed and unpacked on every call, use iterate_bitsliced or
+pdf_bitsliced to keep the state packed over many steps.
+*/
+void model_bitsliced(int *array, int N, Params params)
+{
+	if (bs_cache == NULL || bs_cache->N != N)
+	{
+		bitgrid_free(bs_cache);
+		bs_cache = bitgrid_alloc(N);
+	}
+
+	bitgrid_pack(bs_cache, array);
+	bitgrid_step(bs_cache, params);
+	bitgrid_unpack(bs_cache, array);
+}
+
+/* free the grid cached by model_bitsliced in the calling thread */
+void model_bitsliced_release(void)
+{
+	bitgrid_free(bs_cache);
+	bs_cache = NULL;
+}
+
+/*
+iterate_bitsliced : identical to iterate with model_simple rules, the state
+					stays bit-sliced for all of the steps
+args :
+	array : initial automata state (integer array of length N x N)
+	N     : side length of automata
+	steps : number of iterations to perform
+	params : model parameters (alpha and beta are ignored)
+
+returns :
+	array : final state of the system
+	out_counts : sums of each cell state kind (N, C, E, ...) at each
+				 step of automata evolution
+				 (must be integer array of length (steps x 4 (# of states)))
+*/
+void iterate_bitsliced(int *array, int N, int steps, Params params, int *out_counts)
+{
+	int i, rng_own;
+	Bitgrid *g;
+
+	rng_own = rng_initialize(-1);
+
+	g = bitgrid_alloc(N);
+	bitgrid_pack(g, array);
+
+	for (i = 0; i < steps; i++)
+	{
+		bitgrid_step(g, params);
+		bitgrid_count(g, &(out_counts[i * 4]));
+	}
+
+	bitgrid_unpack(g, array);
+	bitgrid_free(g);
+
+	rng_free(rng_own);
+}
+
+/*
+pdf_bitsliced : identical to pdf with model_simple rules, every run stays
+				bit-sliced from its initial state to its final count
+args :
+	output  : pdf of number of cancer cells in final automata state
+			  (output must be an array of length N * N)
+	params  : model parameters (alpha and beta are ignored)
+*/
+void pdf_bitsliced(double *output, int N, int c_cells, int steps, int runs, Params params)
+{
+	pdf_rolling_bitsliced(output, N, c_cells, steps, 1, 0, runs, params);
+}
+
+/*
+pdf_rolling_bitsliced : identical to pdf_rolling with model_simple rules,
+						every run stays bit-sliced between its samples
+args :
+	output  : pdf of number of cancer cells in the stationary state
+			  (output must be an array of length N * N)
+	params  : model parameters (alpha and beta are ignored)
+*/
+void pdf_rolling_bitsliced(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, Params params)
+{
+	int i, j, t, rng_own, *arr, *temp_output;
+	int types[4];
+	Bitgrid *g;
+
+	rng_own = rng_initialize(-1);
+
+	arr = arr_alloc(N * N);
+	temp_output = arr_alloc(N * N + 1);
+	g = bitgrid_alloc(N);
+
+	for (i = 0; i < runs; i++)
+	{
+		init_state(arr, N, c_cells);
+		bitgrid_pack(g, arr);
+
+		for (j = 0; j < samples; j++)
+		{
+			for (t = 0; t < ((j == 0) ? init_steps : sample_gap); t++)
+			{
+				bitgrid_step(g, params);
+			}
+			bitgrid_count(g, types);
+			temp_output[types[1]]++;
+		}
+	}
+
+	for (i = 0; i < N * N; i++)
+	{
+		output[i] = (double) temp_output[i] / (double) (runs * samples);
+	}
+
+	bitgrid_free(g);
+	arr_free(arr);
+	arr_free(temp_output);
+	rng_free(rng_own);
+}
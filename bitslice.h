@@ -0,0 +1,41 @@
+/*
+  Bit-sliced automata engine
+
+  The four cell states are stored in two bitplanes so that 64 cells of a
+  row are advanced together with word-wide logic, following the in-place
+  sweep of model_simple.
+*/
+
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <stdint.h>
+#include "c_automata.h"
+
+/* bit-sliced automata state */
+typedef struct {
+	int N;          /* side length of automata */
+	int words;      /* 64-bit words per row */
+	uint64_t tail;  /* mask of the valid cells in the last word of a row */
+	uint64_t *lo;   /* low state bit of each cell */
+	uint64_t *hi;   /* high state bit of each cell */
+	uint64_t *inv;  /* cells invaded by proliferation in the current step */
+	uint64_t s[4];  /* xoshiro256** state */
+} Bitgrid;
+
+/* bit grid handling */
+Bitgrid *bitgrid_alloc(int N);
+void bitgrid_free(Bitgrid *g);
+void bitgrid_pack(Bitgrid *g, int *array);
+void bitgrid_unpack(Bitgrid *g, int *array);
+void bitgrid_count(Bitgrid *g, int *output);
+
+/* bit-sliced iteration functions */
+void bitgrid_step(Bitgrid *g, Params params);
+void model_bitsliced(int *array, int N, Params params);
+void model_bitsliced_release(void);
+void iterate_bitsliced(int *array, int N, int steps, Params params, int *out_counts);
+void pdf_bitsliced(double *output, int N, int c_cells, int steps, int runs, Params params);
+void pdf_rolling_bitsliced(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, Params params);
+
+#endif
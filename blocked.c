@@ -0,0 +1,288 @@
+/*
+ Temporally blocked automata engine
+
+ model_simple / model_extend sweep the grid in place in row-major order, a
+ cell seeing the cells before it already updated and the cells after it
+ not yet updated, and T_CANCER_TEMP cells are only turned into cancer cells
+ once the sweep is over. Updating row i reads and writes rows i - reach to
+ i + reach (reach 1 for proliferation, 2 for the density stencil of
+ model_extend), so
+	- row i of a step is final (its T_CANCER_TEMP cells can be converted and
+	  the row counted) once the step has updated row i + reach
+	- the next step can update row i once rows up to i + reach are final,
+	  ie. once the step has updated row i + 2 reach
+ Steps t, t + 1, ..., t + block - 1 are therefore run together as a
+ wavefront, step t + s updating row w - 2 reach s at time w : about
+ 2 reach block rows are in flight instead of the whole grid being streamed
+ through memory for every step, and the fix-up and counting passes are
+ folded into the wavefront. The order of the updates seen by every cell is
+ that of the reference sweep.
+
+ Random numbers come from a counter-based generator (the splitmix64
+ output function applied to a key and the (step, cell, draw) counter), so
+ they do not depend on the order in which the cells are updated, and any
+ block gives bit for bit the same results. The key is drawn from the gsl
+ rng, so seeding rng_initialize seeds this engine too.
+ */
+
+#include <stdlib.h>
+#include "blocked.h"
+
+/* random draws of a cell per step */
+#define DRAW_STATE 0
+#define DRAW_PROLIFERATE 1
+#define DRAW_NEIGHBOUR 2
+#define DRAWS 4
+
+
+/* ------------------------------------------------------------------------------------- */
+/* counter-based random numbers */
+/* ------------------------------------------------------------------------------------- */
+
+/* uniform on [0, 1) for draw 'd' of cell 'cell' at step 'step' */
+static inline double counter_uniform(uint64_t key, uint64_t step, uint64_t cells, uint64_t cell, int d)
+{
+	uint64_t z = key + ((step * cells + cell) * DRAWS + d + 1) * 0x9E3779B97F4A7C15ull;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	z = z ^ (z >> 31);
+	return (z >> 11) * 0x1.0p-53;
+}
+
+/* key of a run, from the gsl rng */
+static uint64_t counter_key(void)
+{
+	return ((uint64_t) gsl_rng_get(rng) << 32) ^ (uint64_t) gsl_rng_get(rng);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* row updates */
+/* ------------------------------------------------------------------------------------- */
+
+/* cell (i, j), with row-major addressing when the layout allows it */
+#define AT(array, N, rowmajor, i, j) ((rowmajor) ? &(array)[(size_t) (i) * (N) + (j)] : &(array)[grid_index(N, i, j)])
+
+/* proliferate with the numbers rp (decision) and rc (choice of neighbour) */
+static inline void blocked_proliferate(int *array, int N, int rowmajor, int i, int j, double k1, int competition, double rp, double rc)
+{
+	int k, x, y, *p;
+	int neigh_c = 0, neigh_n = 0;
+	int *norm_neighbours[4];
+	double k1_prime;
+	static const int di[4] = {0, 1, 0, -1};  /* order of order_neighbours */
+	static const int dj[4] = {1, 0, -1, 0};
+
+	for (k = 0; k < 4; k++)
+	{
+		x = i + di[k];
+		y = j + dj[k];
+		if (!(0 <= x && x < N && 0 <= y && y < N))
+		{
+			continue;
+		}
+		p = AT(array, N, rowmajor, x, y);
+		if (*p == T_NORMAL)
+		{
+			norm_neighbours[neigh_n] = p;
+			neigh_n++;
+		}
+		else if (*p == T_CANCER)
+		{
+			neigh_c++;
+		}
+	}
+
+	k1_prime = competition ? k1 * (1 - ((double) neigh_c) / 4.00) : k1;
+	if (rp < k1_prime && neigh_n > 0)
+	{
+		*(norm_neighbours[(int) (rc * neigh_n)]) = T_CANCER_TEMP;
+	}
+}
+
+/* cell_density of C and E cells around (i, j) in one pass over the stencil */
+static inline void blocked_density(int *array, int N, int rowmajor, int i, int j, double *density_c, double *density_e)
+{
+	int k, l, v;
+	double w, dc = 0.0, de = 0.0;
+
+	for (k = -2; k <= 2; k++)
+	{
+		if (i + k < 0 || i + k >= N)
+		{
+			continue;
+		}
+		for (l = -2; l <= 2; l++)
+		{
+			if (j + l < 0 || j + l >= N || (k == 0 && l == 0))
+			{
+				continue;
+			}
+			v = *AT(array, N, rowmajor, i + k, j + l);
+			w = (abs(k) == 1 && abs(l) == 1) ? 2.00 : 1.00;
+			dc += (v == T_CANCER) ? w : 0.0;
+			de += (v == T_EFFECTOR) ? w : 0.0;
+		}
+	}
+	*density_c = fmin(dc / 32.0, 1.0);
+	*density_e = fmin(de / 32.0, 1.0);
+}
+
+/* update row i at step 'step' (the rules of model_extend, model_simple if extend = 0) */
+static void sweep_row(int *array, int N, int i, uint64_t key, uint64_t step, Params *params, int extend)
+{
+	int j, *p;
+	int rowmajor = (grid_layout == LAYOUT_ROWMAJOR);
+	uint64_t cell, cells = (uint64_t) N * N;
+	double r, k2p, density_c, density_e;
+	double *probs = params->probs;
+
+	for (j = 0; j < N; j++)
+	{
+		cell = (uint64_t) i * N + j;
+		r = counter_uniform(key, step, cells, cell, DRAW_STATE);
+		p = AT(array, N, rowmajor, i, j);
+
+		if (*p == T_NORMAL && r < probs[0]) /* N -> C :: MUTATION */
+		{
+			*p = T_CANCER;
+		}
+		else if (*p == T_CANCER)
+		{
+			blocked_proliferate(array, N, rowmajor, i, j, probs[1], params->competition,
+								counter_uniform(key, step, cells, cell, DRAW_PROLIFERATE),
+								counter_uniform(key, step, cells, cell, DRAW_NEIGHBOUR));
+
+			k2p = probs[2];
+			if (extend)
+			{
+				blocked_density(array, N, rowmajor, i, j, &density_c, &density_e);
+				k2p = 1 - (1 - probs[2] * pow(1 - density_c, params->alpha)) * exp(-density_e * params->beta);
+			}
+			if (r < k2p) /* C -> E :: EFFECTION */
+			{
+				*p = T_EFFECTOR;
+			}
+		}
+		else if (*p == T_EFFECTOR && r < probs[3]) /* E -> D :: DEATH */
+		{
+			*p = T_DEAD;
+		}
+		else if (*p == T_DEAD && r < probs[4]) /* D -> N :: REBIRTH */
+		{
+			*p = T_NORMAL;
+		}
+	}
+}
+
+/* convert the T_CANCER_TEMP cells of row i and add its cell types to counts (NULL for none) */
+static void finish_row(int *array, int N, int i, int *counts)
+{
+	int j, *p;
+	int rowmajor = (grid_layout == LAYOUT_ROWMAJOR);
+
+	for (j = 0; j < N; j++)
+	{
+		p = AT(array, N, rowmajor, i, j);
+		if (*p == T_CANCER_TEMP)
+		{
+			*p = T_CANCER;
+		}
+		if (counts != NULL)
+		{
+			counts[*p]++;
+		}
+	}
+}
+
+/* run steps first_step ... first_step + block - 1 as one wavefront */
+static void wavefront(int *array, int N, int block, uint64_t key, uint64_t first_step, Params *params, int *out_counts)
+{
+	int w, s, r, f;
+	int extend = (params->alpha != 0.0 || params->beta != 0.0);
+	int reach = extend ? 2 : 1;
+	int lag = 2 * reach;
+
+	if (out_counts != NULL)
+	{
+		memset(out_counts, 0, (size_t) block * 4 * sizeof(int));
+	}
+
+	for (w = 0; w < N + (block - 1) * lag + reach; w++)
+	{
+		for (s = 0; s < block; s++)
+		{
+			r = w - s * lag;
+			if (r >= 0 && r < N)
+			{
+				sweep_row(array, N, r, key, first_step + s, params, extend);
+			}
+
+			f = r - reach;  /* last read of row f by step s was the update of row r */
+			if (f >= 0 && f < N)
+			{
+				finish_row(array, N, f, (out_counts != NULL) ? &out_counts[s * 4] : NULL);
+			}
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* iteration functions */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+model_blocked : apply the automata rules (model_extend, or model_simple if
+				alpha = beta = 0) with the counter-based random numbers,
+				single step version of iterate_blocked
+args:
+	array  : automata state
+	N	   : side length of automata
+	params : model parameters
+*/
+void model_blocked(int *array, int N, Params params)
+{
+	wavefront(array, N, 1, counter_key(), 0, &params, NULL);
+}
+
+/*
+iterate_blocked : identical to iterate, running 'block' steps per pass
+				  over the grid
+args :
+	array  : initial automata state
+	N      : side length of automata
+	steps  : number of iterations to perform
+	block  : steps per pass (block >= 1), 0 to keep about BLOCK_CACHE bytes
+			 of rows in flight
+	params : model parameters
+
+returns :
+	array      : final automata state
+	out_counts : sums of each cell state after each step
+				 (must be integer array of length steps x 4)
+*/
+void iterate_blocked(int *array, int N, int steps, int block, Params params, int *out_counts)
+{
+	int t, rng_own, lag;
+	uint64_t key;
+
+	assert(block >= 0);
+	rng_own = rng_initialize(-1);
+	key = counter_key();
+
+	if (block == 0)
+	{
+		lag = (params.alpha != 0.0 || params.beta != 0.0) ? 4 : 2;
+		block = BLOCK_CACHE / ((size_t) lag * N * sizeof(int));
+		block = (block < 1) ? 1 : block;
+	}
+
+	for (t = 0; t < steps; t += block)
+	{
+		wavefront(array, N, (steps - t < block) ? steps - t : block, key, t, &params, &out_counts[t * 4]);
+	}
+
+	rng_free(rng_own);
+}
@@ -0,0 +1,22 @@
+/*
+  Temporally blocked automata engine
+
+  Advances the automata several steps per pass over the grid, the steps
+  following each other a few rows apart so that the rows in flight stay
+  in cache. Random numbers are addressed by (step, cell), so results do not
+  depend on the blocking.
+*/
+
+#ifndef BLOCKED_H
+#define BLOCKED_H
+
+#include <stdint.h>
+#include "c_automata.h"
+
+#define BLOCK_CACHE (256 << 10)  /* bytes of rows in flight aimed for by block = 0 (within L2) */
+
+/* blocked iteration functions */
+void model_blocked(int *array, int N, Params params);
+void iterate_blocked(int *array, int N, int steps, int block, Params params, int *out_counts);
+
+#endif
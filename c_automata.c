@@ -3,23 +3,28 @@
  */
 
 #include "c_automata.h"
+#include "clusters.h"
+#include "render.h"
 
-#define T_NORMAL 0
-#define T_CANCER 1
-#define T_CANCER_TEMP 111
-#define T_EFFECTOR 2
-#define T_DEAD 3
+#define DISPLAY_MAX_SIZE 100  /* largest grid shown without downsampling */
 
 /* gsl random number global */ 
 /* 
    commit the sin of a global variable so that random number generator does not
    have to be initialized every time a random variable is required.
+   (one per thread, so that Simulator workers each draw from their own stream)
 */
-int rng_initialized = 0;
-gsl_rng * rng;
+__thread int rng_initialized = 0;
+__thread gsl_rng * rng;
+
+/* storage layout of automata states, see grid_index */
+int grid_layout = LAYOUT_ROWMAJOR;
 
 const Params params_default = { .probs = {0.00, 0.48, 0.1, 0.3, 0.1}, .competition = 1, .alpha = 0.0, .beta = 0.0 };
 
+static void pdf_runs(double *output, int N, int c_cells, int *init, int n_init, int steps, int runs, modelPtr model, Params params);
+static void pdf_rolling_runs(double *output, int N, int c_cells, int *init, int n_init, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params, double *size_pdf, double *number_pdf);
+
 
 /* ------------------------------------------------------------------------------------- */
 /* automata pdf calculating functions */
@@ -41,6 +46,42 @@ args :
 	competition : cancer cells compete for resources
 */
 void pdf(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params)
+{
+	pdf_runs(output, N, c_cells, NULL, 0, steps, runs, model, params);
+}
+
+/*
+pdf_init : identical to pdf except that each run starts from a copy of a
+		   pre-built initial state instead of a random one
+
+args :
+	init   : pre-built automata states (n_init integer arrays of length N x N,
+			 stored back to back), run i starts from state i % n_init
+	n_init : number of pre-built states (n_init >= 1)
+*/
+void pdf_init(double *output, int N, int *init, int n_init, int steps, int runs, modelPtr model, Params params)
+{
+	assert(init != NULL && n_init >= 1);
+	pdf_runs(output, N, 0, init, n_init, steps, runs, model, params);
+}
+
+/*
+run_state : initial state of run 'run', either random with c_cells cancer cells
+			(init == NULL) or a copy of one of the n_init pre-built states
+*/
+static void run_state(int *arr, int N, int c_cells, int *init, int n_init, int run)
+{
+	if (init == NULL)
+	{
+		init_state(arr, N, c_cells);
+	}
+	else
+	{
+		memcpy(arr, &init[(size_t) (run % n_init) * N * N], (size_t) N * N * sizeof(int));
+	}
+}
+
+static void pdf_runs(double *output, int N, int c_cells, int *init, int n_init, int steps, int runs, modelPtr model, Params params)
 {
 	int i, rng_own, *arr, *temp_output;
 	int types[4];
@@ -53,7 +94,7 @@ void pdf(double *output, int N, int c_cells, int steps, int runs, modelPtr model
 	/* simulate automata systems */
 	for (i = 0; i < runs; i++)
 	{
-		init_state(arr, N, c_cells);
+		run_state(arr, N, c_cells, init, n_init, i);
 		iterate_endcount(arr, N, steps, model, params, types);
 		
 		/* DEBUG */
@@ -103,26 +144,77 @@ args :
 */
 void pdf_rolling(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params)
 {
-	int i, j, rng_own, *arr, *temp_output;
+	pdf_rolling_runs(output, N, c_cells, NULL, 0, init_steps, samples, sample_gap, runs, model, params, NULL, NULL);
+}
+
+/*
+pdf_rolling_init : identical to pdf_rolling except that each run starts from a
+				   copy of a pre-built initial state (see pdf_init)
+*/
+void pdf_rolling_init(double *output, int N, int *init, int n_init, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params)
+{
+	assert(init != NULL && n_init >= 1);
+	pdf_rolling_runs(output, N, 0, init, n_init, init_steps, samples, sample_gap, runs, model, params, NULL, NULL);
+}
+
+/*
+pdf_rolling_clusters : identical to pdf_rolling but also collects statistics
+					   of the tumours (clusters of cancer cells) at every sample
+
+returns :
+	size_pdf   : pdf of the size of a tumour over all tumours in all samples
+				 i.e. pdf(tumour size = s) -> size_pdf[s]
+				 (must be an array of length N * N + 1)
+	number_pdf : pdf of the number of tumours in a sample
+				 i.e. pdf(# of tumours = n) -> number_pdf[n]
+				 (must be an array of length N * N + 1)
+*/
+void pdf_rolling_clusters(double *output, double *size_pdf, double *number_pdf, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params)
+{
+	assert(size_pdf != NULL && number_pdf != NULL);
+	pdf_rolling_runs(output, N, c_cells, NULL, 0, init_steps, samples, sample_gap, runs, model, params, size_pdf, number_pdf);
+}
+
+static void pdf_rolling_runs(double *output, int N, int c_cells, int *init, int n_init, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params, double *size_pdf, double *number_pdf)
+{
+	int i, j, k, rng_own, *arr, *temp_output;
+	int *parent = NULL, *size_count = NULL, *number_count = NULL;
 	int types[4];
+	long n_clusters = 0;
 	
 	rng_own = rng_initialize(-1);
 	
 	arr = arr_alloc(N * N);  /* allocate memory for automata state */
 	temp_output = arr_alloc(N * N);  /* allocate memory for counting occurences of x_c values */
 	
+	if (size_pdf != NULL)
+	{
+		parent = arr_alloc(N * N);  /* union-find work space */
+		size_count = arr_alloc(N * N + 1);
+		number_count = arr_alloc(N * N + 1);
+	}
+	
 	/* simulate automata systems */
 	for (i = 0; i < runs; i++)
 	{
-		init_state(arr, N, c_cells); /* create random initial condition */
+		run_state(arr, N, c_cells, init, n_init, i); /* create initial condition */
 		
-		iterate_endcount(arr, N, init_steps, model, params, types); /* initialise automata state */
-		temp_output[types[1]]++; /* add sample */
-		
-		for (j = 0; j < samples - 1; j++)
+		for (j = 0; j < samples; j++)
 		{
-			iterate_endcount(arr, N, sample_gap, model, params, types); /* jump forward in the stationary state */
+			if (j == 0)
+			{
+				iterate_endcount(arr, N, init_steps, model, params, types); /* initialise automata state */
+			}
+			else
+			{
+				iterate_endcount(arr, N, sample_gap, model, params, types); /* jump forward in the stationary state */
+			}
 			temp_output[types[1]]++; /* add sample */
+			
+			if (size_pdf != NULL)
+			{
+				number_count[cluster_sizes(arr, N, parent, size_count)]++;
+			}
 		}
 	}
 	
@@ -132,6 +224,23 @@ void pdf_rolling(double *output, int N, int c_cells, int init_steps, int samples
 		output[i] = (double) temp_output[i] / (double) (runs * samples);
 	}
 	
+	if (size_pdf != NULL)
+	{
+		for (k = 0; k <= N * N; k++)
+		{
+			n_clusters += size_count[k];
+		}
+		for (k = 0; k <= N * N; k++)
+		{
+			size_pdf[k] = (n_clusters > 0) ? (double) size_count[k] / (double) n_clusters : 0.0;
+			number_pdf[k] = (double) number_count[k] / (double) (runs * samples);
+		}
+		
+		arr_free(parent);
+		arr_free(size_count);
+		arr_free(number_count);
+	}
+	
 	arr_free(arr);
 	arr_free(temp_output);
 	rng_free(rng_own);
@@ -227,246 +336,274 @@ returns :
 */
 void init_state(int *array, int N, int m)
 {
-	int i, x, y, rng_own;
-	int placed = 0;
+	int k, t, id, rng_own;
+	int total = N * N;
 	
+	assert(layout_supported(grid_layout, N));
+	assert(0 <= m && m <= total);
 	rng_own = rng_initialize(-1);
 	
 	/* initialize array to zero */
-	for (i = 0; i < N * N; i++)
-	{
-		array[i] = 0;
-	}
+	memset(array, 0, (size_t) total * sizeof(int));
 	
-	while (placed < m)
+	/* Floyd's algorithm : exact uniform choice of m distinct cells in O(m) */
+	for (k = total - m; k < total; k++)
 	{
-		x = gsl_rng_uniform_int(rng, N);
-		y = gsl_rng_uniform_int(rng, N);
+		t = gsl_rng_uniform_int(rng, k + 1);
+		id = grid_index(N, t / N, t % N);
 		
-		if (array[N * x + y] != 1)
+		if (array[id] == T_CANCER) /* t already chosen, take k instead */
 		{
-			array[N * x + y] = 1;
-			placed++;
+			id = grid_index(N, k / N, k % N);
 		}
-		
+		array[id] = T_CANCER;
 	}
 	
 	rng_free(rng_own);
 }
 
-
-
-/* ------------------------------------------------------------------------------------- */
-/* automata iteration functions */
-/* ------------------------------------------------------------------------------------- */
-
 /*
-model_simple : apply the automata rules to the state of the automata
-args:
-	array : automata state
-	N	  : side length of automata
+init_density : initializes the state of the automata with a random
+			   arrangement of cells in given proportions (eg. a stationary
+			   state predicted by meanfield_stationary)
 
-params **
-	prob  : transition probabilities {k0, k1, k2, k3, k4} of
-			automata states.
-	competition : cancer cells compete for resources
+args : 
+	array   : empty array of length N x N
+	N 	    : side length of automata
+	density : fractions of N, C, E, D cells (the N cells take up
+			  the rounding)
+
+returns :
+	array : state of automata
 */
-void model_simple(int *array, int N, Params params)
+void init_density(int *array, int N, double *density)
 {
-	int i, j, id, *p, competition;
-	double r, *probs;
+	int k, t, r, id, rng_own;
+	int total = N * N;
 	
-	/* get model parameters */
-	probs = params.probs;
-	competition = params.competition;
+	assert(layout_supported(grid_layout, N));
+	rng_own = rng_initialize(-1);
 	
-	/* apply automata rules */
+	/* lay the cells out in type order */
 	id = 0;
-	for (i = 0; i < N; i++)
+	for (t = T_DEAD; t > T_NORMAL; t--)
 	{
-		for (j = 0; j < N; j++)
+		for (k = 0; k < (int) (density[t] * total + 0.5) && id < total; k++)
 		{
-			r = gsl_rng_uniform(rng); /* generate random number */
-			p = &array[id];           /* pointer to cell in array */
-			
-			if (*p == T_NORMAL && r < probs[0]) 	  /* N -> C :: MUTATION */
-			{
-				*p = T_CANCER; /* set to C */
-			}
-			else if (*p == T_CANCER)
-			{
-				proliferate(array, N, i, j, probs[1], competition);
-				if (r < probs[2]) /* C -> E :: EFFECTION */
-				{
-					*p = T_EFFECTOR; /* set to E */
-				}
-			}
-			else if (*p == T_EFFECTOR && r < probs[3]) /* E -> D :: DEATH */
-			{
-				*p = T_DEAD; /* set to D */
-			}
-			else if (*p == T_DEAD && r < probs[4]) /* D -> N :: REBIRTH */
-			{
-				*p = T_NORMAL; /* set to N */
-			}
-			
-			id++;
+			array[id++] = t;
 		}
 	}
+	while (id < total)
+	{
+		array[id++] = T_NORMAL;
+	}
 	
-	id = 0;
-	while (id < N * N)
+	/* Fisher-Yates shuffle (uniform, so the grid layout does not matter) */
+	for (k = total - 1; k > 0; k--)
 	{
-		if (array[id] == T_CANCER_TEMP)
-		{
-			array[id] = T_CANCER;
-		}
-		id++;
+		r = gsl_rng_uniform_int(rng, k + 1);
+		t = array[k];
+		array[k] = array[r];
+		array[r] = t;
 	}
+	
+	rng_free(rng_own);
 }
 
 /*
-model_extend : apply the automata rules to the state of the automata
-args:
-	array : automata state
-	N	  : side length of automata
+init_cluster : initializes the state of the automata with a single tumour
+			   of m connected cancer cells
 
-params (struct)
-	prob  : transition probabilities {k0, k1, k2, k3, k4} of
-			automata states.
-	competition : cancer cells compete for resources
+The tumour is grown from a random cell by repeatedly adding a random
+normal neighbour of the tumour (Eden growth), cells touching more of the
+tumour are more likely to be added.
+
+args : 
+	array : empty array of length N x N
+	N 	  : side length of automata
+	m	  : number of cancer cells in the tumour (0 <= m <= N x N)
+
+returns :
+	array : state of automata
 */
-void model_extend(int *array, int N, Params params)
+void init_cluster(int *array, int N, int m)
 {
-	int i, j, id, *p, competition;
-	double r, *probs, density_e, density_c, k2p;
+	int k, r, x, y, cell, rng_own, *frontier, *p;
+	int placed = 0;
+	int n_front = 0;
 	
-	/* get model parameters */
-	probs = params.probs;
-	competition = params.competition;
+	assert(layout_supported(grid_layout, N));
+	assert(0 <= m && m <= N * N);
+	rng_own = rng_initialize(-1);
 	
-	/* apply automata rules */
-	id = 0;
-	for (i = 0; i < N; i++)
+	memset(array, 0, (size_t) N * N * sizeof(int));
+	
+	/* candidate cells (row-major ids), each placed cell adds up to 4 */
+	frontier = arr_alloc(4 * m + 1);
+	if (m > 0)
 	{
-		for (j = 0; j < N; j++)
+		frontier[n_front++] = gsl_rng_uniform_int(rng, N * N);
+	}
+	
+	while (placed < m && n_front > 0)
+	{
+		/* take a random candidate out of the frontier */
+		r = gsl_rng_uniform_int(rng, n_front);
+		cell = frontier[r];
+		frontier[r] = frontier[--n_front];
+		
+		x = cell / N;
+		y = cell % N;
+		p = &array[grid_index(N, x, y)];
+		if (*p == T_CANCER)
 		{
-			r = gsl_rng_uniform(rng); /* generate random number */
-			p = &array[id];           /* pointer to cell in array */
-			
-			if (*p == T_NORMAL && r < probs[0]) 	  /* N -> C :: MUTATION */
-			{
-				*p = T_CANCER; /* set to C */
-			}
-			else if (*p == T_CANCER)
-			{
-				proliferate(array, N, i, j, probs[1], competition); /* cancer cell proliferation */
-				density_c = cell_density(array, N, i, j, T_CANCER); /* compute cancer cell density */
-				density_e = cell_density(array, N, i, j, T_EFFECTOR); /* compute E cell density */
-				
-				/* compute adjusted effection probability */
-				k2p = 1 - (1 - probs[2] * pow(1 - density_c, params.alpha)) * exp(-density_e * params.beta); 
-				
-				if (r < k2p) /* C -> E :: EFFECTION */
-				{
-					*p = T_EFFECTOR; /* set to E */
-				}
-			}
-			else if (*p == T_EFFECTOR && r < probs[3]) /* E -> D :: DEATH */
-			{
-				*p = T_DEAD; /* set to D */
-			}
-			else if (*p == T_DEAD && r < probs[4]) /* D -> N :: REBIRTH */
+			continue;
+		}
+		*p = T_CANCER;
+		placed++;
+		
+		for (k = 0; k < 4; k++)
+		{
+			p = order_neighbours(array, N, x, y, k);
+			if (p != NULL && *p == T_NORMAL)
 			{
-				*p = T_NORMAL; /* set to N */
+				frontier[n_front++] = N * (x + (k == 1) - (k == 3)) + (y + (k == 0) - (k == 2));
 			}
-			
-			id++;
 		}
 	}
 	
-	id = 0;
-	while (id < N * N)
+	arr_free(frontier);
+	rng_free(rng_own);
+}
+
+/*
+state_load : read an automata state from a text file
+
+The file holds the N x N cell values in row-major order separated by
+white space, any '[', ']' and ',' characters are ignored (so the output
+of arr2_print / state_save can be read back).
+
+args :
+	array : array of length N x N, filled in grid_layout
+	N 	  : side length of automata
+	path  : file name
+
+returns :
+	0 on success, -1 if the file can not be read or does not hold N x N
+	valid cell values
+*/
+int state_load(int *array, int N, const char *path)
+{
+	int c, value, count = 0;
+	FILE *f;
+	
+	f = fopen(path, "r");
+	if (f == NULL)
 	{
-		if (array[id] == T_CANCER_TEMP)
+		return -1;
+	}
+	
+	while (count < N * N)
+	{
+		/* skip separators */
+		do
 		{
-			array[id] = T_CANCER;
+			c = fgetc(f);
+		} while (c == '[' || c == ']' || c == ',' || c == ' ' || c == '\t' || c == '\n' || c == '\r');
+		
+		if (c == EOF)
+		{
+			break;
 		}
-		id++;
+		ungetc(c, f);
+		
+		if (fscanf(f, "%d", &value) != 1 || value < T_NORMAL || value > T_DEAD)
+		{
+			break;
+		}
+		array[grid_index(N, count / N, count % N)] = value;
+		count++;
 	}
+	
+	fclose(f);
+	return (count == N * N) ? 0 : -1;
 }
 
 /*
-cancer_density : compute the density of cancer cells at the location (i, j)
+state_save : write an automata state to a text file readable by state_load
 
-args:
-	array : automata state
-	N	  : side length of automata
-	i, j  : coordinate position of proliferating cell
-returns:
-	double : density value between 0.0 and 1.0
+returns :
+	0 on success, -1 if the file can not be written
 */
-double cell_density(int *array, int N, int i, int j, int cell_type)
+int state_save(int *array, int N, const char *path)
 {
-	int k, l;
-	double out = 0.0;
+	int i, j;
+	FILE *f;
 	
-	//printf("(%d, %d) \n", i, j);
-	/* 
-	  loop over 5x5 neighbourhood of cells ignoring the center cell
-	  and cells which fall outside the boundaries of the automata
-	*/
-	for (k = -2; k <= 2; k++)
+	f = fopen(path, "w");
+	if (f == NULL)
 	{
-		for (l = -2; l <= 2; l++)
-		{
-			if (within(N, i + k, j + l) && !(k == 0 && l == 0))
-			{
-				if (cell_type == array[(i + k) * N + (j + l)])
-				{
-					if (abs(k) == 1 && abs(l) == 1)
-					{
-						out += 2.00;
-					}
-					else
-					{
-						out += 1.00;
-					}
-					
-				}
-				
-			}
-		}
+		return -1;
 	}
-	out = out / 32.0;
 	
-	/* check bounds */
-	if (out > 1.0)
+	for (i = 0; i < N; i++)
 	{
-		out = 1.0;
+		for (j = 0; j < N; j++)
+		{
+			fprintf(f, (j < N - 1) ? "%d " : "%d\n", array[grid_index(N, i, j)]);
+		}
 	}
-	if (out < 0.0)
-	{
-		out = 0.0;
-	}
-	return out;
+	
+	return (fclose(f) == 0) ? 0 : -1;
 }
 
+
+
+/* ------------------------------------------------------------------------------------- */
+/* automata iteration functions */
+/* ------------------------------------------------------------------------------------- */
+
 /*
-proliferate : handle proliferation of C cells into neighbouring N cells
-args:
-	array : automata state
-	N	  : side length of automata
-	i, j  : coordinate position of proliferating cell
-	k1    : proliferation rate
-	competition : C cells compete for resources
-		if True (1) then use modified prolif. probability formula
-			k1_prime = k1 * (1 -  ((double) neigh_c) / 4.00);
-		else use
-			k1_prime = k2
+ The sweeps below take the storage layout as an argument and are always
+ inlined with a constant one (see sweep_layout), so every layout gets its
+ own copy of the inner loops with grid_index_as resolved at compile time.
+ The public model functions only choose the copy once per call.
+ */
+#define SWEEP_INLINE static inline __attribute__((always_inline))
 
-*/
-void proliferate(int *array, int N, int i, int j, double k1, int competition)
+/* neighbour k of the cell (i, j) in the order right, down, left, up (NULL outside of the automata) */
+SWEEP_INLINE int *neighbour_as(int layout, int *array, int N, int i, int j, int k)
+{
+	int x, y;
+	
+	switch (k)
+	{
+		case 0:
+			x = i; y = j + 1;
+			break;
+		case 1:
+			x = i + 1; y = j;
+			break;
+		case 2:
+			x = i; y = j - 1;
+			break;
+		default:
+			x = i - 1; y = j;
+			break;
+	}
+	
+	if (within(N, x, y))
+	{
+		return &(array[grid_index_as(layout, N, x, y)]);
+	}
+	else
+	{
+		return NULL;
+	}
+}
+
+/* proliferate for a given layout */
+SWEEP_INLINE void proliferate_as(int layout, int *array, int N, int i, int j, double k1, int competition)
 {
 	int k, rr, *p;
 	int neigh_c = 0;
@@ -478,7 +615,7 @@ void proliferate(int *array, int N, int i, int j, double k1, int competition)
 	for (k = 0; k < 4; k++)
 	{
 		/* get neighbour pointer */
-		p = order_neighbours(array, N, i, j, k);
+		p = neighbour_as(layout, array, N, i, j, k);
 		
 		if (p == NULL) /* not within automata */
 		{
@@ -515,42 +652,287 @@ void proliferate(int *array, int N, int i, int j, double k1, int competition)
 	}
 }
 
+/* cell_density for a given layout */
+SWEEP_INLINE double cell_density_as(int layout, int *array, int N, int i, int j, int cell_type)
+{
+	int k, l;
+	double out = 0.0;
+	
+	/* 
+	  loop over 5x5 neighbourhood of cells ignoring the center cell
+	  and cells which fall outside the boundaries of the automata
+	*/
+	for (k = -2; k <= 2; k++)
+	{
+		for (l = -2; l <= 2; l++)
+		{
+			if (within(N, i + k, j + l) && !(k == 0 && l == 0))
+			{
+				if (cell_type == array[grid_index_as(layout, N, i + k, j + l)])
+				{
+					if (abs(k) == 1 && abs(l) == 1)
+					{
+						out += 2.00;
+					}
+					else
+					{
+						out += 1.00;
+					}
+					
+				}
+				
+			}
+		}
+	}
+	out = out / 32.0;
+	
+	/* check bounds */
+	if (out > 1.0)
+	{
+		out = 1.0;
+	}
+	if (out < 0.0)
+	{
+		out = 0.0;
+	}
+	return out;
+}
 
-int *order_neighbours(int *array, int N, int i, int j, int k)
+/* one step of model_simple (extend = 0) or model_extend (extend = 1) for a given layout */
+SWEEP_INLINE void sweep_as(int layout, int extend, int *array, int N, Params params)
 {
-	int x, y;
+	int i, j, id, *p, competition;
+	double r, *probs, density_e, density_c, k2p;
 	
-	switch (k)
+	/* get model parameters */
+	probs = params.probs;
+	competition = params.competition;
+	
+	/* apply automata rules */
+	for (i = 0; i < N; i++)
 	{
-		case 0:
-			x = i; y = j + 1;
-			break;
-		case 1:
-			x = i + 1; y = j;
-			break;
-		case 2:
-			x = i; y = j - 1;
-			break;
-		case 3:
-			x = i - 1; y = j;
-			break;
+		for (j = 0; j < N; j++)
+		{
+			r = gsl_rng_uniform(rng); /* generate random number */
+			p = &array[grid_index_as(layout, N, i, j)]; /* pointer to cell in array */
+			
+			if (*p == T_NORMAL && r < probs[0]) 	  /* N -> C :: MUTATION */
+			{
+				*p = T_CANCER; /* set to C */
+			}
+			else if (*p == T_CANCER)
+			{
+				proliferate_as(layout, array, N, i, j, probs[1], competition); /* cancer cell proliferation */
+				k2p = probs[2];
+				if (extend)
+				{
+					density_c = cell_density_as(layout, array, N, i, j, T_CANCER); /* compute cancer cell density */
+					density_e = cell_density_as(layout, array, N, i, j, T_EFFECTOR); /* compute E cell density */
+					
+					/* compute adjusted effection probability */
+					k2p = 1 - (1 - probs[2] * pow(1 - density_c, params.alpha)) * exp(-density_e * params.beta); 
+				}
+				
+				if (r < k2p) /* C -> E :: EFFECTION */
+				{
+					*p = T_EFFECTOR; /* set to E */
+				}
+			}
+			else if (*p == T_EFFECTOR && r < probs[3]) /* E -> D :: DEATH */
+			{
+				*p = T_DEAD; /* set to D */
+			}
+			else if (*p == T_DEAD && r < probs[4]) /* D -> N :: REBIRTH */
+			{
+				*p = T_NORMAL; /* set to N */
+			}
+		}
 	}
 	
-	if (within(N, x, y))
+	id = 0;
+	while (id < N * N)
 	{
-		return &(array[N * x + y]);
+		if (array[id] == T_CANCER_TEMP)
+		{
+			array[id] = T_CANCER;
+		}
+		id++;
 	}
-	else
+}
+
+/* sweep with the copy of the inner loops for the current grid_layout */
+SWEEP_INLINE void sweep_layout(int extend, int *array, int N, Params params)
+{
+	switch (grid_layout)
 	{
-		return NULL;
+		case LAYOUT_TILED:
+			sweep_as(LAYOUT_TILED, extend, array, N, params);
+			break;
+		case LAYOUT_MORTON:
+			sweep_as(LAYOUT_MORTON, extend, array, N, params);
+			break;
+		default:
+			sweep_as(LAYOUT_ROWMAJOR, extend, array, N, params);
+			break;
 	}
 }
 
+/*
+model_simple : apply the automata rules to the state of the automata
+args:
+	array : automata state
+	N	  : side length of automata
+
+params **
+	prob  : transition probabilities {k0, k1, k2, k3, k4} of
+			automata states.
+	competition : cancer cells compete for resources
+*/
+void model_simple(int *array, int N, Params params)
+{
+	sweep_layout(0, array, N, params);
+}
+
+/*
+model_extend : apply the automata rules to the state of the automata
+args:
+	array : automata state
+	N	  : side length of automata
+
+params (struct)
+	prob  : transition probabilities {k0, k1, k2, k3, k4} of
+			automata states.
+	competition : cancer cells compete for resources
+*/
+void model_extend(int *array, int N, Params params)
+{
+	sweep_layout(1, array, N, params);
+}
+
+/*
+cancer_density : compute the density of cancer cells at the location (i, j)
+
+args:
+	array : automata state
+	N	  : side length of automata
+	i, j  : coordinate position of proliferating cell
+returns:
+	double : density value between 0.0 and 1.0
+*/
+double cell_density(int *array, int N, int i, int j, int cell_type)
+{
+	return cell_density_as(grid_layout, array, N, i, j, cell_type);
+}
+
+/*
+proliferate : handle proliferation of C cells into neighbouring N cells
+args:
+	array : automata state
+	N	  : side length of automata
+	i, j  : coordinate position of proliferating cell
+	k1    : proliferation rate
+	competition : C cells compete for resources
+		if True (1) then use modified prolif. probability formula
+			k1_prime = k1 * (1 -  ((double) neigh_c) / 4.00);
+		else use
+			k1_prime = k2
+
+*/
+void proliferate(int *array, int N, int i, int j, double k1, int competition)
+{
+	proliferate_as(grid_layout, array, N, i, j, k1, competition);
+}
+
+
+int *order_neighbours(int *array, int N, int i, int j, int k)
+{
+	return neighbour_as(grid_layout, array, N, i, j, k);
+}
+
 int within(int N, int i, int j)
 {
 	return (0 <= i) && (i < N) && (0 <= j) && (j < N);
 }
 
+/* ------------------------------------------------------------------------------------- */
+/* grid layout functions */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+set_layout : choose the storage layout used for all automata states
+
+args :
+	layout : LAYOUT_ROWMAJOR, LAYOUT_TILED (LAYOUT_TILE x LAYOUT_TILE blocks)
+			 or LAYOUT_MORTON (Z-curve, N must be a power of two)
+
+Notes :
+	states are always swept in row-major (i, j) order, so a layout only
+	changes where cells live in memory and not the simulation results
+	for a given seed. Arrays created under one layout must be converted
+	(layout_export / layout_import) before use under another.
+*/
+void set_layout(int layout)
+{
+	assert(layout == LAYOUT_ROWMAJOR || layout == LAYOUT_TILED || layout == LAYOUT_MORTON);
+	grid_layout = layout;
+}
+
+/*
+layout_supported : returns 1 if an automata of side length N can be stored
+				   with the given layout, 0 otherwise
+*/
+int layout_supported(int layout, int N)
+{
+	switch (layout)
+	{
+		case LAYOUT_ROWMAJOR:
+		case LAYOUT_TILED:
+			return 1;
+		case LAYOUT_MORTON:
+			return N >= 1 && N <= (1 << 15) && (N & (N - 1)) == 0;
+		default:
+			return 0;
+	}
+}
+
+/*
+layout_import : copy a row-major automata state into the current layout
+
+args :
+	dst : automata state in grid_layout (integer array of length N x N)
+	src : row-major automata state (integer array of length N x N)
+	N   : side length of automata
+*/
+void layout_import(int *dst, int *src, int N)
+{
+	int i, j;
+	
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < N; j++)
+		{
+			dst[grid_index(N, i, j)] = src[N * i + j];
+		}
+	}
+}
+
+/*
+layout_export : copy an automata state in the current layout into
+				row-major order (inverse of layout_import)
+*/
+void layout_export(int *dst, int *src, int N)
+{
+	int i, j;
+	
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < N; j++)
+		{
+			dst[N * i + j] = src[grid_index(N, i, j)];
+		}
+	}
+}
+
 /* ------------------------------------------------------------------------------------- */
 /* display functions */
 /* ------------------------------------------------------------------------------------- */
@@ -563,13 +945,16 @@ args :
 	N     : side length of automata
 	steps : number of iterations to perform
 	probs : transition probabilities of cellular automata
-	time_delay : number of milli-seconds between each state output
-				 (default: 40,000 -- set to zero to use default)
+	time_delay : number of micro-seconds between each state output
+				 (default: 400,000 -- set to zero to use default)
+
+Notes :
+	only the cells that changed are redrawn, automata larger than
+	DISPLAY_MAX_SIZE are shown downsampled (see render.c)
 */
 void iterate_display(int *array, int N, int steps, modelPtr model, Params params, int time_delay)
 {
-	int i;
-	int dummy_count[4];
+	Renderer *r;
 	
 	/* Handle default for time_delay */
 	if (time_delay == 0)
@@ -582,13 +967,9 @@ void iterate_display(int *array, int N, int steps, modelPtr model, Params params
 	}
 
 	/* Iterate and print through automata states */
-	for (i = 0; i < steps; i++)
-	{
-		automata_print(array, N);
-		usleep(time_delay);
-		iterate(array, N, 1, model, params, dummy_count);
-	}
-	automata_print(array, N);
+	r = render_alloc(N, DISPLAY_MAX_SIZE, 1, NULL);
+	iterate_render(array, N, steps, model, params, r, 1, time_delay);
+	render_free(r);
 }
 
 /*
@@ -599,38 +980,51 @@ void iterate_display(int *array, int N, int steps, modelPtr model, Params params
 */
 void automata_print(int *arr, int N)
 {
-	int i, j, id;
+	int i, j;
+	size_t len = 0;
+	char *buf;
+	const char *s;
+	
+	/* build the whole frame and write it at once (glyphs are at most 3 bytes) */
+	buf = (char *) malloc((size_t) N * N * 4 + (size_t) N * 16 + 16);
+	if (buf == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
 	
-	printf("\n\n\n");
+	memcpy(buf + len, "\n\n\n ", 4); len += 4;
 	
 	/* Head Boundary */
-	printf(" ");
 	for (i = 0; i < N; i++)
 	{
-		printf("__");
+		memcpy(buf + len, "__", 2); len += 2;
 	}
-	printf(" \n");
+	memcpy(buf + len, " \n", 2); len += 2;
 	
 	/* Automata Grid */
-	id = 0;
 	for (i = 0; i < N; i++)
 	{
-		printf("|");
+		buf[len++] = '|';
 		for (j = 0; j < N; j++)
 		{
-			printf("%s ", rep(arr[id]));
-			id++;
+			s = rep(arr[grid_index(N, i, j)]);
+			memcpy(buf + len, s, strlen(s)); len += strlen(s);
+			buf[len++] = ' ';
 		}
-		printf("|\n");
+		memcpy(buf + len, "|\n", 2); len += 2;
 	}
 	
 	/* Tail Boundary */
-	printf(" ");
+	buf[len++] = ' ';
 	for (i = 0; i < N; i++)
 	{
-		printf("‾‾");
+		memcpy(buf + len, "‾‾", strlen("‾‾")); len += strlen("‾‾");
 	}
-	printf(" \n");
+	memcpy(buf + len, " \n", 2); len += 2;
+	
+	fwrite(buf, 1, len, stdout);
+	free(buf);
 }
 
 
@@ -691,7 +1085,7 @@ void type_count(int *array, int N, int *output)
 		output[i] = 0;
 	}
 	
-	/* iterate through array */
+	/* iterate through array (the count does not depend on grid_layout) */
 	id = 0;
 	for (i = 0; i < N; i++)
 	{
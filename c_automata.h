@@ -5,14 +5,25 @@ Things to do:
 - link to python script
 */
 
+#ifndef C_AUTOMATA_H
+#define C_AUTOMATA_H
+
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <assert.h>
 #include <gsl/gsl_rng.h>
 #include "arrays.h"
 
+/* cell types */
+#define T_NORMAL 0
+#define T_CANCER 1
+#define T_CANCER_TEMP 111
+#define T_EFFECTOR 2
+#define T_DEAD 3
+
 /* model parameter struct */
 typedef struct {
 	double probs[5];
@@ -23,6 +34,66 @@ typedef struct {
 
 extern const Params params_default;
 
+/* gsl random number global, one per thread (defined in c_automata.c) */
+extern __thread gsl_rng *rng;
+extern __thread int rng_initialized;
+
+/* grid storage layouts */
+#define LAYOUT_ROWMAJOR 0
+#define LAYOUT_TILED 1
+#define LAYOUT_MORTON 2
+#define LAYOUT_TILE 32  /* side length of a tile in the tiled layout */
+
+/* storage layout of every automata state (defined in c_automata.c) */
+extern int grid_layout;
+
+/* grid layout functions */
+void set_layout(int layout);
+int layout_supported(int layout, int N);
+void layout_import(int *dst, int *src, int N);
+void layout_export(int *dst, int *src, int N);
+
+/*
+grid_index_as : position of the cell (i, j) in an automata state stored
+				with the given layout (inlined with a constant layout, the
+				switch is resolved at compile time)
+*/
+static inline __attribute__((always_inline)) int grid_index_as(int layout, int N, int i, int j)
+{
+	unsigned int ti, tj, h, w, x, y;
+
+	switch (layout)
+	{
+		case LAYOUT_TILED:
+			/* row-major tiles, row-major cells within a tile, edge tiles are cut short */
+			ti = (unsigned int) i / LAYOUT_TILE * LAYOUT_TILE;
+			tj = (unsigned int) j / LAYOUT_TILE * LAYOUT_TILE;
+			h = ((unsigned int) N - ti < LAYOUT_TILE) ? (unsigned int) N - ti : LAYOUT_TILE;
+			w = ((unsigned int) N - tj < LAYOUT_TILE) ? (unsigned int) N - tj : LAYOUT_TILE;
+			return (int) (ti * N + tj * h + ((unsigned int) i - ti) * w + ((unsigned int) j - tj));
+		case LAYOUT_MORTON:
+			/* interleave the bits of i and j (N must be a power of two) */
+			x = (unsigned int) i;
+			y = (unsigned int) j;
+			x = (x | (x << 8)) & 0x00FF00FF; y = (y | (y << 8)) & 0x00FF00FF;
+			x = (x | (x << 4)) & 0x0F0F0F0F; y = (y | (y << 4)) & 0x0F0F0F0F;
+			x = (x | (x << 2)) & 0x33333333; y = (y | (y << 2)) & 0x33333333;
+			x = (x | (x << 1)) & 0x55555555; y = (y | (y << 1)) & 0x55555555;
+			return (int) ((x << 1) | y);
+		default:
+			return N * i + j;
+	}
+}
+
+/*
+grid_index : position of the cell (i, j) in an automata state stored
+			 with the current grid_layout
+*/
+static inline int grid_index(int N, int i, int j)
+{
+	return grid_index_as(grid_layout, N, i, j);
+}
+
 /* model function pointer */
 /* a pointer to function that takes an integer pointer, an integer 
    and a struct type Params, returns void */
@@ -31,6 +102,9 @@ typedef void (*modelPtr)(int *, int, Params);
 /* automata pdf calculating functions */
 void pdf(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params);
 void pdf_rolling(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+void pdf_init(double *output, int N, int *init, int n_init, int steps, int runs, modelPtr model, Params params);
+void pdf_rolling_init(double *output, int N, int *init, int n_init, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+void pdf_rolling_clusters(double *output, double *size_pdf, double *number_pdf, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
 
 /* automata iteration functions */
 void iterate(int *array, int N, int steps, modelPtr model, Params params, int *out_counts);
@@ -39,6 +113,10 @@ void iterate_endcount(int *array, int N, int steps, modelPtr model, Params param
 /* state properties functions */
 void type_count(int *array, int N, int *output);
 void init_state(int *array, int N, int m);
+void init_cluster(int *array, int N, int m);
+void init_density(int *array, int N, double *density);
+int state_load(int *array, int N, const char *path);
+int state_save(int *array, int N, const char *path);
 
 /* automata iteration functions */
 void model_simple(int *array, int N, Params params);
@@ -56,3 +134,5 @@ char *rep(int value);
 /* random number generator handling */
 int rng_initialize(int seed);
 void rng_free(int rng_own);
+
+#endif
@@ -1,3 +1,14 @@
+cdef extern from "arrays.h":
+	enum:
+		ARR_PLAIN
+		ARR_ALIGNED
+		ARR_THP
+		ARR_HUGETLB
+	
+	void arr_set_policy(int policy)
+	int arr_get_policy()
+
+
 cdef extern from "c_automata.h":
 	ctypedef struct Params:
 		double probs[5];
@@ -9,10 +20,95 @@ cdef extern from "c_automata.h":
 
 	void pdf(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params);
 	void pdf_rolling(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+	void pdf_init(double *output, int N, int *init, int n_init, int steps, int runs, modelPtr model, Params params);
+	void pdf_rolling_clusters(double *output, double *size_pdf, double *number_pdf, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+	void pdf_rolling_init(double *output, int N, int *init, int n_init, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
 	void init_state(int *array, int N, int m)
+	void init_cluster(int *array, int N, int m)
+	void init_density(int *array, int N, double *density)
+	int state_load(int *array, int N, const char *path)
+	int state_save(int *array, int N, const char *path)
 	void iterate(int *array, int N, int steps, modelPtr model, Params params, int *out_counts);
 	void model_simple(int *array, int N, Params params);
 	void model_extend(int *array, int N, Params params);
 	
+	enum:
+		LAYOUT_ROWMAJOR
+		LAYOUT_TILED
+		LAYOUT_MORTON
+	
+	int grid_layout
+	void set_layout(int layout)
+	int layout_supported(int layout, int N)
+	void layout_import(int *dst, int *src, int N)
+	void layout_export(int *dst, int *src, int N)
+	
     #void iterate_endcount(int *array, int N, int steps, double *probs, int competition, int *out_counts)
-    #void type_count(int *array, int N, int *output)
\ No newline at end of file
+    #void type_count(int *array, int N, int *output)
+
+cdef extern from "bitslice.h":
+	void model_bitsliced(int *array, int N, Params params);
+	void iterate_bitsliced(int *array, int N, int steps, Params params, int *out_counts);
+	void pdf_bitsliced(double *output, int N, int c_cells, int steps, int runs, Params params);
+	void pdf_rolling_bitsliced(double *output, int N, int c_cells, int init_steps, int samples, int sample_gap, int runs, Params params);
+
+
+cdef extern from "transition.h":
+	void model_vector(int *array, int N, Params params);
+	int transition_set_isa(int isa);
+	int transition_isa();
+
+
+cdef extern from "clusters.h":
+	int cluster_sizes(int *array, int N, int *parent, int *size_hist);
+	void iterate_clusters(int *array, int N, int steps, modelPtr model, Params params, int *out_counts, int *out_clusters, int *size_hist);
+
+
+cdef extern from "meanfield.h":
+	enum:
+		MF_MEAN_FIELD
+		MF_PAIR
+	
+	void meanfield_trajectory(double *output, double *init, int order, Params params, int steps);
+	int meanfield_stationary(double *density, double *init, int order, Params params, double tol, int max_steps);
+
+
+cdef extern from "splitting.h":
+	long pdf_splitting(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params, int *levels, int n_levels, int split, int upper);
+
+
+cdef extern from "passage.h":
+	enum:
+		FP_ABOVE
+		FP_BELOW
+	
+	ctypedef struct Threshold:
+		int type
+		int level
+		int direction
+	
+	int first_passage(int *array, int N, int max_steps, modelPtr model, Params params, Threshold *thresholds, int n_thresholds, int *times);
+
+
+cdef extern from "blocked.h":
+	void model_blocked(int *array, int N, Params params);
+	void iterate_blocked(int *array, int N, int steps, int block, Params params, int *out_counts);
+
+
+cdef extern from "coupled.h":
+	void iterate_coupled(int *arrays, int n, int N, int steps, Params *params, int *out_counts);
+	void endcount_coupled(int *output, int n, int N, int c_cells, int steps, int runs, Params *params);
+
+
+cdef extern from "simulator.h" nogil:
+	ctypedef struct Simulator:
+		int N
+		int threads
+	
+	Simulator *sim_alloc(int N, int threads, long seed);
+	void sim_free(Simulator *s);
+	void sim_seed(Simulator *s, long seed);
+	void sim_pdf(Simulator *s, double *output, int c_cells, int steps, int runs, modelPtr model, Params params);
+	void sim_pdf_rolling(Simulator *s, double *output, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+	void sim_iterate(Simulator *s, int *array, int steps, modelPtr model, Params params, int *out_counts);
+	long sim_first_passage(Simulator *s, int *hist, int c_cells, int max_steps, int runs, modelPtr model, Params params, Threshold *thresholds, int n_thresholds);
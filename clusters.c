@@ -0,0 +1,140 @@
+/*
+ Connected components of cancer cells
+
+ A single row-major sweep links every cancer cell to its left and upper
+ neighbours with a union-find (union by size, path halving). The sweep
+ reads the state only in the current and previous rows, but a find follows
+ parent links to the root of the tree, which can be a cell in any earlier
+ row (path halving keeps these walks short). Roots hold minus the size of
+ their tree and non-cancer cells hold N x N.
+ */
+
+#include "clusters.h"
+
+/* root of the tree holding cell x */
+static inline int uf_find(int *parent, int x)
+{
+	while (parent[x] >= 0)
+	{
+		if (parent[parent[x]] >= 0)
+		{
+			parent[x] = parent[parent[x]]; /* path halving */
+		}
+		x = parent[x];
+	}
+	return x;
+}
+
+/* merge the trees holding cells a and b, the larger tree keeps its root */
+static inline void uf_union(int *parent, int a, int b)
+{
+	int t;
+
+	a = uf_find(parent, a);
+	b = uf_find(parent, b);
+	if (a == b)
+	{
+		return;
+	}
+	if (parent[a] > parent[b]) /* tree a is smaller */
+	{
+		t = a; a = b; b = t;
+	}
+	parent[a] += parent[b];
+	parent[b] = a;
+}
+
+/*
+cluster_sizes : find the clusters of cancer cells in an automata state
+
+args :
+	array  : automata state
+	N      : side length of automata
+	parent : work space (integer array of length N x N)
+
+returns :
+	size_hist : size_hist[s] is incremented once for every cluster of s
+				cells (must be integer array of length N x N + 1)
+	int       : number of clusters
+*/
+int cluster_sizes(int *array, int N, int *parent, int *size_hist)
+{
+	int i, j, id, n;
+	int none = N * N;
+
+	/* link cancer cells to their left and upper neighbours */
+	id = 0;
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < N; j++)
+		{
+			if (array[grid_index(N, i, j)] != T_CANCER)
+			{
+				parent[id] = none;
+			}
+			else
+			{
+				parent[id] = -1;
+				if (j > 0 && parent[id - 1] != none)
+				{
+					uf_union(parent, id - 1, id);
+				}
+				if (i > 0 && parent[id - N] != none)
+				{
+					uf_union(parent, id - N, id);
+				}
+			}
+			id++;
+		}
+	}
+
+	/* every root is one cluster */
+	n = 0;
+	for (id = 0; id < N * N; id++)
+	{
+		if (parent[id] < 0)
+		{
+			size_hist[-parent[id]]++;
+			n++;
+		}
+	}
+	return n;
+}
+
+/*
+iterate_clusters : identical to iterate but also collects cluster statistics
+				   of the cancer cells after every step
+args :
+	array : initial automata state (integer array of length N x N)
+	N     : side length of automata
+	steps : number of iterations to perform
+	model : automata iteration rules
+	params : model parameters
+
+returns :
+	array : final state of the system
+	out_counts   : sums of each cell state kind (N, C, E, ...) at each step
+				   (must be integer array of length (steps x 4 (# of states)))
+	out_clusters : number of clusters at each step
+				   (must be integer array of length steps)
+	size_hist    : size_hist[s] is incremented for every cluster of s cells
+				   found after any of the steps
+				   (must be integer array of length N x N + 1)
+*/
+void iterate_clusters(int *array, int N, int steps, modelPtr model, Params params, int *out_counts, int *out_clusters, int *size_hist)
+{
+	int i, rng_own, *parent;
+
+	rng_own = rng_initialize(-1);
+	parent = arr_alloc(N * N);
+
+	for (i = 0; i < steps; i++)
+	{
+		(*model)(array, N, params);  /* apply automata iteration rules */
+		type_count(array, N, &(out_counts[i * 4]));
+		out_clusters[i] = cluster_sizes(array, N, parent, size_hist);
+	}
+
+	arr_free(parent);
+	rng_free(rng_own);
+}
@@ -0,0 +1,17 @@
+/*
+  Cluster statistics of cancer cells
+
+  Tumours are the connected components of cancer cells under the 4 cell
+  neighbourhood used by order_neighbours.
+*/
+
+#ifndef CLUSTERS_H
+#define CLUSTERS_H
+
+#include "c_automata.h"
+
+/* cluster functions */
+int cluster_sizes(int *array, int N, int *parent, int *size_hist);
+void iterate_clusters(int *array, int N, int steps, modelPtr model, Params params, int *out_counts, int *out_clusters, int *size_hist);
+
+#endif
@@ -0,0 +1,271 @@
+/*
+ Coupled replicas with common random numbers
+
+ The replicas are stored interleaved, cell after cell with the n replica
+ states of a cell next to each other (state[id * n + v], id the cell's
+ index in grid_layout), so one sweep loads every cell of every replica
+ once. Each cell draws three random numbers per step whatever its state :
+ r for the transition, rp for the proliferation decision and rc for the
+ choice of the invaded neighbour. All replicas use the same three, so
+ replicas with equal states and parameters stay equal, and replicas of
+ nearby parameters differ only where the parameters make them differ.
+
+ Each replica follows the model_extend rules (model_simple for
+ alpha = beta = 0) in the order of the reference sweep, so its law is
+ that of the reference model (see test_conformance).
+ */
+
+#include <stdlib.h>
+#include "coupled.h"
+
+#define CELL(state, n, N, i, j, v) ((state)[(size_t) grid_index(N, i, j) * (n) + (v)])
+
+/* neighbour offsets in the order of order_neighbours */
+static const int di[4] = {0, 1, 0, -1};
+static const int dj[4] = {1, 0, -1, 0};
+
+
+/* cell_density of replica v */
+static double coupled_density(int *state, int n, int v, int N, int i, int j, int cell_type)
+{
+	int k, l;
+	double out = 0.0;
+
+	for (k = -2; k <= 2; k++)
+	{
+		for (l = -2; l <= 2; l++)
+		{
+			if (within(N, i + k, j + l) && !(k == 0 && l == 0)
+				&& CELL(state, n, N, i + k, j + l, v) == cell_type)
+			{
+				out += (abs(k) == 1 && abs(l) == 1) ? 2.00 : 1.00;
+			}
+		}
+	}
+	out = out / 32.0;
+	return (out > 1.0) ? 1.0 : out;
+}
+
+/* proliferate of replica v, with the random numbers of the cell */
+static void coupled_proliferate(int *state, int n, int v, int N, int i, int j, Params *params, double rp, double rc)
+{
+	int k, x, y, *p;
+	int neigh_c = 0, neigh_n = 0;
+	int *norm_neighbours[4];
+	double k1_prime;
+
+	for (k = 0; k < 4; k++)
+	{
+		x = i + di[k];
+		y = j + dj[k];
+		if (!within(N, x, y))
+		{
+			continue;
+		}
+		p = &CELL(state, n, N, x, y, v);
+		if (*p == T_NORMAL)
+		{
+			norm_neighbours[neigh_n] = p;
+			neigh_n++;
+		}
+		else if (*p == T_CANCER)
+		{
+			neigh_c++;
+		}
+	}
+
+	k1_prime = params->competition ? params->probs[1] * (1 - ((double) neigh_c) / 4.00) : params->probs[1];
+	if (rp < k1_prime && neigh_n > 0)
+	{
+		*(norm_neighbours[(int) (rc * neigh_n)]) = T_CANCER_TEMP;
+	}
+}
+
+/*
+model_coupled : apply the automata rules to n interleaved replicas, replica
+				v with params[v]
+args:
+	state  : replica states (integer array of length N x N x n, the state
+			 of replica v at cell id is state[id * n + v])
+	n      : number of replicas
+	N      : side length of automata
+	params : model parameters of each replica
+*/
+void model_coupled(int *state, int n, int N, Params *params)
+{
+	int i, j, v, *p;
+	size_t id;
+	double r, rp, rc, k2p, density_c, density_e;
+	double *probs;
+
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < N; j++)
+		{
+			/* common random numbers of the cell */
+			r = gsl_rng_uniform(rng);
+			rp = gsl_rng_uniform(rng);
+			rc = gsl_rng_uniform(rng);
+
+			p = &state[(size_t) grid_index(N, i, j) * n];
+			for (v = 0; v < n; v++)
+			{
+				probs = params[v].probs;
+
+				if (p[v] == T_NORMAL && r < probs[0]) /* N -> C :: MUTATION */
+				{
+					p[v] = T_CANCER;
+				}
+				else if (p[v] == T_CANCER)
+				{
+					coupled_proliferate(state, n, v, N, i, j, &params[v], rp, rc);
+
+					k2p = probs[2];
+					if (params[v].alpha != 0.0 || params[v].beta != 0.0)
+					{
+						density_c = coupled_density(state, n, v, N, i, j, T_CANCER);
+						density_e = coupled_density(state, n, v, N, i, j, T_EFFECTOR);
+						k2p = 1 - (1 - probs[2] * pow(1 - density_c, params[v].alpha)) * exp(-density_e * params[v].beta);
+					}
+					if (r < k2p) /* C -> E :: EFFECTION */
+					{
+						p[v] = T_EFFECTOR;
+					}
+				}
+				else if (p[v] == T_EFFECTOR && r < probs[3]) /* E -> D :: DEATH */
+				{
+					p[v] = T_DEAD;
+				}
+				else if (p[v] == T_DEAD && r < probs[4]) /* D -> N :: REBIRTH */
+				{
+					p[v] = T_NORMAL;
+				}
+			}
+		}
+	}
+
+	for (id = 0; id < (size_t) N * N * n; id++)
+	{
+		if (state[id] == T_CANCER_TEMP)
+		{
+			state[id] = T_CANCER;
+		}
+	}
+}
+
+/* count the cell types of every replica (output : n x 4) */
+static void coupled_count(int *state, int n, int N, int *output)
+{
+	int v;
+	size_t id;
+
+	memset(output, 0, (size_t) n * 4 * sizeof(int));
+	for (id = 0; id < (size_t) N * N; id++)
+	{
+		for (v = 0; v < n; v++)
+		{
+			output[v * 4 + state[id * n + v]]++;
+		}
+	}
+}
+
+/*
+iterate_coupled : step n replicas through "steps" coupled iterations
+args :
+	arrays : initial automata states, one after the other
+			 (integer array of length n x N x N)
+	n      : number of replicas
+	N      : side length of automata
+	steps  : number of iterations to perform
+	params : model parameters of each replica
+
+returns :
+	arrays     : final automata states
+	out_counts : out_counts[(i * n + v) * 4 + type] is the count of 'type'
+				 in replica v after step i (must be integer array of length
+				 steps x n x 4)
+*/
+void iterate_coupled(int *arrays, int n, int N, int steps, Params *params, int *out_counts)
+{
+	int i, v, rng_own;
+	size_t id;
+	int *state;
+
+	rng_own = rng_initialize(-1);
+	state = arr_alloc((size_t) N * N * n);
+
+	for (v = 0; v < n; v++)
+	{
+		for (id = 0; id < (size_t) N * N; id++)
+		{
+			state[id * n + v] = arrays[(size_t) v * N * N + id];
+		}
+	}
+
+	for (i = 0; i < steps; i++)
+	{
+		model_coupled(state, n, N, params);
+		coupled_count(state, n, N, &out_counts[(size_t) i * n * 4]);
+	}
+
+	for (v = 0; v < n; v++)
+	{
+		for (id = 0; id < (size_t) N * N; id++)
+		{
+			arrays[(size_t) v * N * N + id] = state[id * n + v];
+		}
+	}
+
+	arr_free(state);
+	rng_free(rng_own);
+}
+
+/*
+endcount_coupled : final cell type counts of n coupled replicas over runs
+				   from random initial states (the replicas of a run start
+				   from the same state)
+args :
+	n       : number of replicas
+	N       : side length of automata
+	c_cells : number of initial cancer cells
+	steps   : number of iterations of a run
+	runs    : number of runs
+	params  : model parameters of each replica
+
+returns :
+	output : output[(run * n + v) * 4 + type] is the final count of 'type'
+			 in replica v of the run (must be integer array of length
+			 runs x n x 4)
+*/
+void endcount_coupled(int *output, int n, int N, int c_cells, int steps, int runs, Params *params)
+{
+	int run, i, v, rng_own;
+	size_t id;
+	int *arr, *state;
+
+	rng_own = rng_initialize(-1);
+	arr = arr_alloc((size_t) N * N);
+	state = arr_alloc((size_t) N * N * n);
+
+	for (run = 0; run < runs; run++)
+	{
+		init_state(arr, N, c_cells);
+		for (id = 0; id < (size_t) N * N; id++)
+		{
+			for (v = 0; v < n; v++)
+			{
+				state[id * n + v] = arr[id];
+			}
+		}
+
+		for (i = 0; i < steps; i++)
+		{
+			model_coupled(state, n, N, params);
+		}
+		coupled_count(state, n, N, &output[(size_t) run * n * 4]);
+	}
+
+	arr_free(arr);
+	arr_free(state);
+	rng_free(rng_own);
+}
@@ -0,0 +1,19 @@
+/*
+  Coupled replicas with common random numbers
+
+  Advances one automata replica per Params variant in a single sweep, all
+  replicas using the same random numbers, for low variance differences
+  between nearby parameter sets (finite-difference sensitivities).
+*/
+
+#ifndef COUPLED_H
+#define COUPLED_H
+
+#include "c_automata.h"
+
+/* coupled iteration functions */
+void model_coupled(int *state, int n, int N, Params *params);
+void iterate_coupled(int *arrays, int n, int N, int steps, Params *params, int *out_counts);
+void endcount_coupled(int *output, int n, int N, int c_cells, int steps, int runs, Params *params);
+
+#endif
@@ -0,0 +1,315 @@
+/*
+ Mean-field and pair approximations of the automata
+
+ The per-step transition probabilities are used as rates of a continuous
+ time ODE, one unit of time standing for one automata step. This is close
+ to the automata for small probabilities and only a guide otherwise.
+
+ Pair approximation : the state is the density p[a][b] of ordered
+ neighbour pairs of types (a, b) on the square lattice, triples are
+ closed with q(c | a) = p[a][c] / rho[a]. Per pair bond (x, y):
+	- x moves on to type (a + 1) % 4 at rate k0 (N), k2' (C), k3 (E), k4 (D)
+	- an N cell is also invaded by each of its C neighbours at rate w,
+	  y when it is C plus 3 q(C | N) other neighbours on average
+ where w is the probability that a C cell proliferates times the chance
+ that it picks a given normal neighbour. With competition
+	w = E[ k1 (1 - neigh_c / 4) / neigh_n ]
+ over the other 3 neighbours of the C cell distributed as q(. | C).
+ The effection probability k2' is the model_extend law evaluated at the
+ expected densities around a C cell (the 4 nearest cells of the 5 x 5
+ neighbourhood follow q(. | C), the other 24 weights follow rho).
+
+ Mean-field : pairs are taken to be uncorrelated, p[a][b] = rho[a] rho[b].
+ */
+
+#include "meanfield.h"
+
+#define MF_DT 0.05  /* integration step (automata steps) */
+
+/* multinomial coefficients 3! / (i! j! k!) for i + j + k = 3 */
+static const double trinomial[4][4] = {
+	{1, 3, 3, 1},
+	{3, 6, 3, 0},
+	{3, 3, 0, 0},
+	{1, 0, 0, 0}
+};
+
+
+/* ------------------------------------------------------------------------------------- */
+/* rates */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+invasion_weight : rate at which a C cell invades one given normal neighbour
+
+args :
+	q : type distribution of the other 3 neighbours of the C cell
+*/
+static double invasion_weight(const double *q, Params params)
+{
+	int nn, nc, no;
+	double k1_prime, w = 0.0;
+	double q_other = 1.0 - q[T_NORMAL] - q[T_CANCER];
+
+	if (q_other < 0.0)
+	{
+		q_other = 0.0;
+	}
+
+	for (nn = 0; nn <= 3; nn++)
+	{
+		for (nc = 0; nc <= 3 - nn; nc++)
+		{
+			no = 3 - nn - nc;
+			k1_prime = params.competition ? params.probs[1] * (1 - ((double) nc) / 4.00) : params.probs[1];
+			w += trinomial[nn][nc] * pow(q[T_NORMAL], nn) * pow(q[T_CANCER], nc) * pow(q_other, no)
+			   * k1_prime / (double) (nn + 1);
+		}
+	}
+	return w;
+}
+
+/* model_extend effection probability for cell densities dc, de */
+static double effection_prob(double dc, double de, Params params)
+{
+	return 1 - (1 - params.probs[2] * pow(1 - dc, params.alpha)) * exp(-de * params.beta);
+}
+
+/*
+pair_deriv : time derivative of the ordered pair densities p (4 x 4)
+*/
+static void pair_deriv(const double *p, double *dp, Params params)
+{
+	int a, b, k;
+	double m, ra, rb, w, ext, rho[4], qc[4], qcn;
+	double rate[4];
+
+	for (a = 0; a < 4; a++)
+	{
+		rho[a] = 0.0;
+		for (b = 0; b < 4; b++)
+		{
+			rho[a] += p[a * 4 + b];
+		}
+	}
+
+	/* neighbours of a C cell, and chance of a C neighbour for an N cell */
+	for (k = 0; k < 4; k++)
+	{
+		qc[k] = (rho[T_CANCER] > 1e-12) ? p[T_CANCER * 4 + k] / rho[T_CANCER] : rho[k];
+	}
+	qcn = (rho[T_NORMAL] > 1e-12) ? p[T_NORMAL * 4 + T_CANCER] / rho[T_NORMAL] : rho[T_CANCER];
+
+	w = invasion_weight(qc, params);
+	ext = 3 * qcn * w;
+
+	rate[T_NORMAL] = params.probs[0];
+	rate[T_CANCER] = effection_prob((4 * qc[T_CANCER] + 24 * rho[T_CANCER]) / 32.0,
+									(4 * qc[T_EFFECTOR] + 24 * rho[T_EFFECTOR]) / 32.0, params);
+	rate[T_EFFECTOR] = params.probs[3];
+	rate[T_DEAD] = params.probs[4];
+
+	for (k = 0; k < 16; k++)
+	{
+		dp[k] = 0.0;
+	}
+
+	for (a = 0; a < 4; a++)
+	{
+		for (b = 0; b < 4; b++)
+		{
+			m = p[a * 4 + b];
+
+			/* x (type a) moves on */
+			ra = rate[a];
+			if (a == T_NORMAL)
+			{
+				ra += ext + ((b == T_CANCER) ? w : 0.0);
+			}
+			dp[a * 4 + b] -= m * ra;
+			dp[((a + 1) % 4) * 4 + b] += m * ra;
+
+			/* y (type b) moves on */
+			rb = rate[b];
+			if (b == T_NORMAL)
+			{
+				rb += ext + ((a == T_CANCER) ? w : 0.0);
+			}
+			dp[a * 4 + b] -= m * rb;
+			dp[a * 4 + (b + 1) % 4] += m * rb;
+		}
+	}
+}
+
+/*
+deriv : time derivative of the solver state y
+		(16 pair densities, or 4 densities for the mean-field order)
+*/
+static void deriv(const double *y, double *dy, int order, Params params)
+{
+	int a, b;
+	double p[16], dp[16];
+
+	if (order == MF_PAIR)
+	{
+		pair_deriv(y, dy, params);
+		return;
+	}
+
+	/* uncorrelated pairs, the densities change as the pair sums */
+	for (a = 0; a < 4; a++)
+	{
+		for (b = 0; b < 4; b++)
+		{
+			p[a * 4 + b] = y[a] * y[b];
+		}
+	}
+	pair_deriv(p, dp, params);
+	for (a = 0; a < 4; a++)
+	{
+		dy[a] = 0.0;
+		for (b = 0; b < 4; b++)
+		{
+			dy[a] += dp[a * 4 + b];
+		}
+	}
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* solver functions */
+/* ------------------------------------------------------------------------------------- */
+
+/* advance the solver state by one automata step (fourth order Runge-Kutta) */
+static void advance(double *y, int n, int order, Params params)
+{
+	int s, k;
+	double k1[16], k2[16], k3[16], k4[16], t[16];
+
+	for (s = 0; s < (int) (1.0 / MF_DT + 0.5); s++)
+	{
+		deriv(y, k1, order, params);
+		for (k = 0; k < n; k++) t[k] = y[k] + 0.5 * MF_DT * k1[k];
+		deriv(t, k2, order, params);
+		for (k = 0; k < n; k++) t[k] = y[k] + 0.5 * MF_DT * k2[k];
+		deriv(t, k3, order, params);
+		for (k = 0; k < n; k++) t[k] = y[k] + MF_DT * k3[k];
+		deriv(t, k4, order, params);
+		for (k = 0; k < n; k++)
+		{
+			y[k] += MF_DT / 6.0 * (k1[k] + 2 * k2[k] + 2 * k3[k] + k4[k]);
+		}
+	}
+}
+
+/* initial solver state for uncorrelated cell densities init[4] */
+static int start(double *y, double *init, int order)
+{
+	int a, b;
+
+	if (order == MF_PAIR)
+	{
+		for (a = 0; a < 4; a++)
+		{
+			for (b = 0; b < 4; b++)
+			{
+				y[a * 4 + b] = init[a] * init[b];
+			}
+		}
+		return 16;
+	}
+
+	for (a = 0; a < 4; a++)
+	{
+		y[a] = init[a];
+	}
+	return 4;
+}
+
+/* cell densities of the solver state */
+static void densities(double *y, int order, double *out)
+{
+	int a, b;
+
+	for (a = 0; a < 4; a++)
+	{
+		if (order == MF_PAIR)
+		{
+			out[a] = 0.0;
+			for (b = 0; b < 4; b++)
+			{
+				out[a] += y[a * 4 + b];
+			}
+		}
+		else
+		{
+			out[a] = y[a];
+		}
+	}
+}
+
+/*
+meanfield_trajectory : densities of each cell type after each automata step
+
+args :
+	init   : initial densities of N, C, E, D (summing to 1)
+	order  : MF_MEAN_FIELD or MF_PAIR
+	params : model parameters (alpha = beta = 0 for model_simple)
+	steps  : number of automata steps
+
+returns :
+	output : densities after each step (must be array of length steps x 4)
+*/
+void meanfield_trajectory(double *output, double *init, int order, Params params, int steps)
+{
+	int i, n;
+	double y[16];
+
+	n = start(y, init, order);
+	for (i = 0; i < steps; i++)
+	{
+		advance(y, n, order, params);
+		densities(y, order, &output[i * 4]);
+	}
+}
+
+/*
+meanfield_stationary : stationary densities of each cell type
+
+args :
+	init      : initial densities of N, C, E, D (summing to 1)
+	order     : MF_MEAN_FIELD or MF_PAIR
+	params    : model parameters (alpha = beta = 0 for model_simple)
+	tol       : largest change of the state over one step accepted as stationary
+	max_steps : most automata steps to integrate
+
+returns :
+	density : densities of N, C, E, D at the end of the integration
+	int     : number of steps taken, -1 if not converged after max_steps
+*/
+int meanfield_stationary(double *density, double *init, int order, Params params, double tol, int max_steps)
+{
+	int i, k, n;
+	double y[16], prev[16], change;
+
+	n = start(y, init, order);
+	for (i = 1; i <= max_steps; i++)
+	{
+		memcpy(prev, y, n * sizeof(double));
+		advance(y, n, order, params);
+
+		change = 0.0;
+		for (k = 0; k < n; k++)
+		{
+			change = fmax(change, fabs(y[k] - prev[k]));
+		}
+		if (change < tol)
+		{
+			densities(y, order, density);
+			return i;
+		}
+	}
+
+	densities(y, order, density);
+	return -1;
+}
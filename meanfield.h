@@ -0,0 +1,21 @@
+/*
+  Mean-field and pair approximations of the automata
+
+  Deterministic ODEs for the densities of N, C, E and D cells under the
+  model_simple / model_extend rules, for cheap parameter screening.
+*/
+
+#ifndef MEANFIELD_H
+#define MEANFIELD_H
+
+#include "c_automata.h"
+
+/* approximation orders */
+#define MF_MEAN_FIELD 0
+#define MF_PAIR 1
+
+/* solver functions */
+void meanfield_trajectory(double *output, double *init, int order, Params params, int steps);
+int meanfield_stationary(double *density, double *init, int order, Params params, double tol, int max_steps);
+
+#endif
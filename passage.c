@@ -0,0 +1,72 @@
+/*
+ First-passage times of the cell type counts
+
+ The counts are taken after every step (and of the initial state, which
+ gives time 0), so a run costs no more than iterate without keeping the
+ count trajectory. Thresholds are only checked until they are first met.
+ */
+
+#include "passage.h"
+
+/* is the threshold met by the counts 'types' */
+static int reached(const Threshold *t, const int *types)
+{
+	if (t->direction == FP_ABOVE)
+	{
+		return types[t->type] >= t->level;
+	}
+	return types[t->type] <= t->level;
+}
+
+/*
+first_passage : step the automata until every threshold has been reached
+				(or for max_steps steps)
+args :
+	array        : initial automata state
+	N            : side length of automata
+	max_steps    : most iterations to perform
+	model        : automata iteration rules
+	params       : model parameters
+	thresholds   : thresholds on the cell type counts
+	n_thresholds : number of thresholds
+
+returns :
+	times : first step at which each threshold is met (0 for the initial
+			state), -1 if not met within max_steps
+			(must be integer array of length n_thresholds)
+	int   : number of steps performed
+*/
+int first_passage(int *array, int N, int max_steps, modelPtr model, Params params, Threshold *thresholds, int n_thresholds, int *times)
+{
+	int i, k, open, rng_own;
+	int types[4];
+
+	rng_own = rng_initialize(-1);
+
+	type_count(array, N, types);
+	open = 0;
+	for (k = 0; k < n_thresholds; k++)
+	{
+		assert(thresholds[k].type >= T_NORMAL && thresholds[k].type <= T_DEAD);
+		times[k] = reached(&thresholds[k], types) ? 0 : -1;
+		open += (times[k] < 0);
+	}
+
+	for (i = 0; i < max_steps && open > 0; i++)
+	{
+		(*model)(array, N, params);  /* apply automata iteration rules */
+		type_count(array, N, types);
+
+		for (k = 0; k < n_thresholds; k++)
+		{
+			if (times[k] < 0 && reached(&thresholds[k], types))
+			{
+				times[k] = i + 1;
+				open--;
+			}
+		}
+	}
+
+	rng_free(rng_own);
+	return i;
+}
@@ -0,0 +1,28 @@
+/*
+  First-passage times of the cell type counts
+
+  Records the first step at which a cell type count crosses each of a set
+  of thresholds (eg. tumour extinction, a given cancer fraction), stopping
+  the run as soon as every threshold has been reached.
+*/
+
+#ifndef PASSAGE_H
+#define PASSAGE_H
+
+#include "c_automata.h"
+
+/* threshold directions */
+#define FP_ABOVE 0  /* count >= level */
+#define FP_BELOW 1  /* count <= level */
+
+/* first-passage threshold */
+typedef struct {
+	int type;       /* cell type (T_NORMAL ... T_DEAD) */
+	int level;      /* cell count */
+	int direction;  /* FP_ABOVE or FP_BELOW */
+} Threshold;
+
+/* first-passage functions */
+int first_passage(int *array, int N, int max_steps, modelPtr model, Params params, Threshold *thresholds, int n_thresholds, int *times);
+
+#endif
@@ -0,0 +1,394 @@
+/*
+ Buffered, diff-based automata renderer
+
+ The terminal grid is drawn in full once, after that every frame only
+ moves the cursor (ANSI escape codes) to the cells whose displayed type
+ changed. Automata larger than 'max_size' are shown downsampled, each
+ displayed cell standing for a scale x scale block of cells.
+
+ Image frames are copied into a small ring of slots and written as binary
+ PPM files by a writer thread, so the simulation only pays for the copy.
+ If the thread cannot be started, render_frame writes the images itself.
+ */
+
+#include <stdlib.h>
+#include "render.h"
+
+/* colours of N, C, E, D (and any other value) in images */
+static const unsigned char colours[5][3] = {
+	{235, 235, 235},
+	{200, 30, 30},
+	{30, 90, 200},
+	{60, 60, 60},
+	{255, 200, 0}
+};
+
+
+/* ------------------------------------------------------------------------------------- */
+/* frame building */
+/* ------------------------------------------------------------------------------------- */
+
+static void buf_add(Renderer *r, const char *s)
+{
+	size_t n = strlen(s);
+
+	memcpy(r->buf + r->len, s, n);
+	r->len += n;
+}
+
+static void buf_move(Renderer *r, int row, int col)
+{
+	r->len += sprintf(r->buf + r->len, "\033[%d;%dH", row, col);
+}
+
+/*
+block_type : type displayed for the block of cells behind the displayed
+			 cell (a, b), the most common type in the block
+			 (ties go to C, then E, then D, then N)
+*/
+static int block_type(Renderer *r, int *array, int a, int b)
+{
+	int i, j, k, v, best;
+	int counts[5] = {0, 0, 0, 0, 0};
+	int order[4] = {T_CANCER, T_EFFECTOR, T_DEAD, T_NORMAL};
+
+	if (r->scale == 1)
+	{
+		return array[grid_index(r->N, a, b)];
+	}
+
+	for (i = a * r->scale; i < (a + 1) * r->scale && i < r->N; i++)
+	{
+		for (j = b * r->scale; j < (b + 1) * r->scale && j < r->N; j++)
+		{
+			v = array[grid_index(r->N, i, j)];
+			counts[(v >= 0 && v < 4) ? v : 4]++;
+		}
+	}
+
+	best = T_CANCER;
+	for (k = 1; k < 4; k++)
+	{
+		if (counts[order[k]] > counts[best])
+		{
+			best = order[k];
+		}
+	}
+	return best;
+}
+
+/* ------------------------------------------------------------------------------------- */
+/* image writer */
+/* ------------------------------------------------------------------------------------- */
+
+/* write one frame of size x size types as <prefix>NNNNNN.ppm */
+static void write_image(Renderer *r, const unsigned char *types, int frame)
+{
+	int k, v;
+	size_t n = (size_t) r->size * r->size;
+	FILE *f;
+
+	for (k = 0; k < (int) n; k++)
+	{
+		v = (types[k] < 4) ? types[k] : 4;
+		memcpy(&r->pixels[3 * k], colours[v], 3);
+	}
+
+	sprintf(r->path, "%s%06d.ppm", r->prefix, frame);
+	f = fopen(r->path, "wb");
+	if (f != NULL)
+	{
+		fprintf(f, "P6\n%d %d\n255\n", r->size, r->size);
+		fwrite(r->pixels, 3, n, f);
+		fclose(f);
+	}
+	else
+	{
+		fprintf(stderr, "Could not write %s\n", r->path);
+	}
+}
+
+static void *image_writer(void *arg)
+{
+	int slot, frame;
+	Renderer *r = (Renderer *) arg;
+
+	while (1)
+	{
+		/* wait for a queued frame */
+		pthread_mutex_lock(&r->lock);
+		while (r->count == 0 && !r->stop)
+		{
+			pthread_cond_wait(&r->filled, &r->lock);
+		}
+		if (r->count == 0)
+		{
+			pthread_mutex_unlock(&r->lock);
+			break;
+		}
+		slot = (r->head - r->count + RENDER_SLOTS) % RENDER_SLOTS;
+		frame = r->slot_frame[slot];
+		pthread_mutex_unlock(&r->lock);
+
+		/* write it outside of the lock */
+		write_image(r, &r->slots[(size_t) slot * r->size * r->size], frame);
+
+		pthread_mutex_lock(&r->lock);
+		r->count--;
+		pthread_cond_signal(&r->emptied);
+		pthread_mutex_unlock(&r->lock);
+	}
+
+	return NULL;
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* renderer handling */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+render_alloc : create a renderer for an automata of side length N
+
+args :
+	N        : side length of automata
+	max_size : largest side length of the displayed grid, larger automata
+			   are downsampled (0 to never downsample)
+	terminal : draw the frames to stdout (0 / 1)
+	prefix   : write every frame to the image <prefix>NNNNNN.ppm
+			   (NULL for no images)
+*/
+Renderer *render_alloc(int N, int max_size, int terminal, const char *prefix)
+{
+	int k;
+	Renderer *r;
+
+	r = (Renderer *) calloc(1, sizeof(Renderer));
+	if (r == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	r->N = N;
+	r->scale = (max_size > 0 && N > max_size) ? (N + max_size - 1) / max_size : 1;
+	r->size = (N + r->scale - 1) / r->scale;
+	r->terminal = terminal;
+
+	r->shown = arr_alloc(r->size * r->size);
+	for (k = 0; k < r->size * r->size; k++)
+	{
+		r->shown[k] = -1;
+	}
+
+	/* worst case : cursor move, 3 byte glyph and a space for every cell */
+	r->buf = (char *) malloc((size_t) r->size * r->size * 24 + (size_t) r->size * 16 + 64);
+	if (r->buf == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	if (prefix != NULL)
+	{
+		r->prefix = strdup(prefix);
+		r->slots = (unsigned char *) malloc((size_t) RENDER_SLOTS * r->size * r->size);
+		r->pixels = (unsigned char *) malloc((size_t) 3 * r->size * r->size);
+		r->path = (char *) malloc(strlen(prefix) + 16);
+		if (r->prefix == NULL || r->slots == NULL || r->pixels == NULL || r->path == NULL)
+		{
+			fprintf(stderr, "Out of memory!");
+			exit(1);
+		}
+		pthread_mutex_init(&r->lock, NULL);
+		pthread_cond_init(&r->filled, NULL);
+		pthread_cond_init(&r->emptied, NULL);
+		r->threaded = (pthread_create(&r->writer, NULL, image_writer, r) == 0);
+		if (!r->threaded)
+		{
+			fprintf(stderr, "Could not start the image writer, images are written synchronously\n");
+		}
+	}
+
+	return r;
+}
+
+/*
+render_free : wait for the queued images to be written and free the renderer
+*/
+void render_free(Renderer *r)
+{
+	if (r == NULL)
+	{
+		return;
+	}
+
+	if (r->prefix != NULL)
+	{
+		pthread_mutex_lock(&r->lock);
+		r->stop = 1;
+		pthread_cond_signal(&r->filled);
+		pthread_mutex_unlock(&r->lock);
+		if (r->threaded)
+		{
+			pthread_join(r->writer, NULL);
+		}
+
+		pthread_mutex_destroy(&r->lock);
+		pthread_cond_destroy(&r->filled);
+		pthread_cond_destroy(&r->emptied);
+		free(r->prefix);
+		free(r->slots);
+		free(r->pixels);
+		free(r->path);
+	}
+
+	arr_free(r->shown);
+	free(r->buf);
+	free(r);
+}
+
+/*
+render_frame : draw the automata state to the terminal and / or queue it
+			   for the image writer
+args :
+	r     : renderer
+	array : automata state
+*/
+void render_frame(Renderer *r, int *array)
+{
+	int a, b, v, id, last;
+	unsigned char *slot = NULL;
+
+	/* claim an image slot (waits while the writer is RENDER_SLOTS frames behind) */
+	if (r->prefix != NULL)
+	{
+		pthread_mutex_lock(&r->lock);
+		while (r->count == RENDER_SLOTS)
+		{
+			pthread_cond_wait(&r->emptied, &r->lock);
+		}
+		slot = &r->slots[(size_t) r->head * r->size * r->size];
+		pthread_mutex_unlock(&r->lock);
+	}
+
+	r->len = 0;
+	if (r->terminal && !r->drawn)
+	{
+		/* clear screen and draw the boundary */
+		buf_add(r, "\033[2J\033[H ");
+		for (b = 0; b < r->size; b++)
+		{
+			buf_add(r, "__");
+		}
+		buf_add(r, " \n");
+		for (a = 0; a < r->size; a++)
+		{
+			buf_move(r, a + 2, 1);
+			buf_add(r, "|");
+			buf_move(r, a + 2, 2 * r->size + 2);
+			buf_add(r, "|");
+		}
+		buf_move(r, r->size + 2, 1);
+		buf_add(r, " ");
+		for (b = 0; b < r->size; b++)
+		{
+			buf_add(r, "‾‾");
+		}
+		buf_add(r, " ");
+		r->drawn = 1;
+	}
+
+	id = 0;
+	for (a = 0; a < r->size; a++)
+	{
+		last = -2;
+		for (b = 0; b < r->size; b++)
+		{
+			v = block_type(r, array, a, b);
+			if (slot != NULL)
+			{
+				slot[id] = (unsigned char) ((v >= 0 && v < 4) ? v : 4);
+			}
+
+			if (r->terminal && v != r->shown[id])
+			{
+				/* the cursor is already in place after the previous cell */
+				if (last != b - 1)
+				{
+					buf_move(r, a + 2, 2 * b + 2);
+				}
+				buf_add(r, rep(v));
+				buf_add(r, " ");
+				r->shown[id] = v;
+				last = b;
+			}
+			id++;
+		}
+	}
+
+	if (r->terminal)
+	{
+		buf_move(r, r->size + 3, 1);
+		fwrite(r->buf, 1, r->len, stdout);
+		fflush(stdout);
+	}
+
+	/* hand the frame to the writer, or write it here without one */
+	if (slot != NULL && !r->threaded)
+	{
+		write_image(r, slot, r->frames++);
+	}
+	else if (slot != NULL)
+	{
+		pthread_mutex_lock(&r->lock);
+		r->slot_frame[r->head] = r->frames;
+		r->head = (r->head + 1) % RENDER_SLOTS;
+		r->count++;
+		r->frames++;
+		pthread_cond_signal(&r->filled);
+		pthread_mutex_unlock(&r->lock);
+	}
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* display functions */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+iterate_render : step automata through "steps" iterations rendering the
+				 state every "every" steps
+args :
+	array : initial automata state
+	N     : side length of automata
+	steps : number of iterations to perform
+	model : automata iteration rules
+	params : model parameters
+	r     : renderer created for side length N
+	every : steps between rendered frames (every >= 1)
+	time_delay : number of micro-seconds to pause after each frame
+*/
+void iterate_render(int *array, int N, int steps, modelPtr model, Params params, Renderer *r, int every, int time_delay)
+{
+	int i, rng_own;
+
+	assert(r->N == N && every >= 1 && time_delay >= 0);
+	rng_own = rng_initialize(-1);
+
+	render_frame(r, array);
+	for (i = 1; i <= steps; i++)
+	{
+		(*model)(array, N, params);  /* apply automata iteration rules */
+		if (i % every == 0 || i == steps)
+		{
+			if (time_delay > 0)
+			{
+				usleep(time_delay);
+			}
+			render_frame(r, array);
+		}
+	}
+
+	rng_free(rng_own);
+}
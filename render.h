@@ -0,0 +1,50 @@
+/*
+  Buffered automata renderer
+
+  Frames are built in one buffer and only the cells that changed since the
+  previous frame are redrawn. Large automata are downsampled and frames
+  can also be written as an image sequence by a background thread.
+*/
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <pthread.h>
+#include "c_automata.h"
+
+#define RENDER_SLOTS 4  /* frames queued for the image writer */
+
+/* renderer state */
+typedef struct {
+	int N;          /* side length of automata */
+	int scale;      /* side length of the block of cells behind a displayed cell */
+	int size;       /* side length of the displayed grid */
+	int terminal;   /* draw to stdout */
+	int drawn;      /* a full frame has been drawn to the terminal */
+	int *shown;     /* type displayed at each position of the terminal grid */
+	char *buf;      /* terminal frame buffer */
+	size_t len;     /* bytes used in buf */
+
+	/* image sequence writer */
+	char *prefix;   /* images are written to <prefix>000000.ppm, ... (NULL for none) */
+	int frames;     /* frames handed to the writer */
+	unsigned char *slots;        /* RENDER_SLOTS frames of size x size types */
+	unsigned char *pixels;       /* RGB image being written */
+	char *path;                  /* path of the image being written */
+	int threaded;                /* the writer thread runs (else frames are written by render_frame) */
+	int slot_frame[RENDER_SLOTS];
+	int head, count, stop;
+	pthread_mutex_t lock;
+	pthread_cond_t filled, emptied;
+	pthread_t writer;
+} Renderer;
+
+/* renderer handling */
+Renderer *render_alloc(int N, int max_size, int terminal, const char *prefix);
+void render_free(Renderer *r);
+void render_frame(Renderer *r, int *array);
+
+/* display functions */
+void iterate_render(int *array, int N, int steps, modelPtr model, Params params, Renderer *r, int every, int time_delay);
+
+#endif
@@ -11,8 +11,8 @@ setup(
     ext_modules = [
         Extension(
             "automata",
-            sources=["automata.pyx", "c_automata.c", "arrays.c"],
-            libraries=['gsl', 'gslcblas'],
+            sources=["automata.pyx", "c_automata.c", "arrays.c", "bitslice.c", "transition.c", "clusters.c", "render.c", "meanfield.c", "splitting.c", "simulator.c", "passage.c", "coupled.c", "blocked.c"],
+            libraries=['gsl', 'gslcblas', 'pthread'],
             include_dirs=[numpy.get_include(), "/usr/local/include"],
             library_dirs=["/usr/local/lib"]
         )
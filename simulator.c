@@ -0,0 +1,449 @@
+/*
+ Persistent simulator
+
+ Every worker thread installs its own gsl stream as the thread's rng, so
+ the automata functions (which call rng_initialize / rng_free) find an
+ initialized generator and never allocate or reseed one. A call hands a
+ job to the workers, which split the runs between them and count into
+ their own histograms, the histograms are summed once at the end. Before
+ exiting, a worker frees the buffers the engines cache per thread.
+
+ Calls on the same simulator are serialised by its call lock, as the
+ arguments of a job are kept in the simulator.
+
+ The grid and histogram of a worker are first written by the worker itself,
+ and their strides are rounded up to whole pages (of the kernel's base
+ page size). They start on page
+ boundaries, and so are placed on the worker's NUMA node, only when the
+ arena is mapped : under ARR_ALIGNED, ARR_THP or ARR_HUGETLB, for an arena
+ of at least ARR_MAP_MIN bytes whose mapping succeeded. Under ARR_PLAIN
+ (calloc) the slices have no alignment guarantee and neighbouring workers
+ may share a page. Under ARR_THP and ARR_HUGETLB, slices smaller than a
+ 2 MB huge page share it with their neighbours.
+ */
+
+#include <stdlib.h>
+#include "simulator.h"
+#include "bitslice.h"
+#include "transition.h"
+
+#define HIST(s, k) (&(s)->hist[(k) * (s)->hist_stride])
+#define GRID(s, k) (&(s)->arena[(k) * (s)->grid_stride])
+
+/* worker handed to pthread_create */
+typedef struct {
+	Simulator *s;
+	int k;
+} Worker;
+
+
+/* ------------------------------------------------------------------------------------- */
+/* worker pool */
+/* ------------------------------------------------------------------------------------- */
+
+static void *worker_main(void *arg)
+{
+	int seen = 0;
+	Worker w = *(Worker *) arg;
+	Simulator *s = w.s;
+
+	free(arg);
+
+	/* the worker's stream is the rng of this thread */
+	rng = s->rngs[w.k];
+	rng_initialized = 1;
+
+	while (1)
+	{
+		pthread_mutex_lock(&s->lock);
+		while (s->generation == seen && !s->quit)
+		{
+			pthread_cond_wait(&s->start, &s->lock);
+		}
+		if (s->quit)
+		{
+			pthread_mutex_unlock(&s->lock);
+			break;
+		}
+		seen = s->generation;
+		pthread_mutex_unlock(&s->lock);
+
+		(*s->job)(s, w.k);
+
+		pthread_mutex_lock(&s->lock);
+		s->pending--;
+		if (s->pending == 0)
+		{
+			pthread_cond_signal(&s->done);
+		}
+		pthread_mutex_unlock(&s->lock);
+	}
+
+	model_bitsliced_release();
+	model_vector_release();
+	rng_initialized = 0;
+	return NULL;
+}
+
+/* run a job on all workers and wait for it to finish */
+static void run_job(Simulator *s, jobPtr job)
+{
+	pthread_mutex_lock(&s->lock);
+	s->job = job;
+	s->pending = s->threads;
+	s->generation++;
+	pthread_cond_broadcast(&s->start);
+	while (s->pending > 0)
+	{
+		pthread_cond_wait(&s->done, &s->lock);
+	}
+	pthread_mutex_unlock(&s->lock);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* jobs */
+/* ------------------------------------------------------------------------------------- */
+
+/* first touch of the worker's own grid and histogram */
+static void job_touch(Simulator *s, int k)
+{
+	memset(GRID(s, k), 0, s->grid_stride * sizeof(int));
+	memset(HIST(s, k), 0, s->hist_stride * sizeof(int));
+}
+
+/* worker k takes runs k, k + threads, ... of a pdf */
+static void job_pdf(Simulator *s, int k)
+{
+	int i;
+	int types[4];
+	int *arr = GRID(s, k), *hist = HIST(s, k);
+
+	memset(hist, 0, ((size_t) s->N * s->N + 1) * sizeof(int));
+	for (i = k; i < s->runs; i += s->threads)
+	{
+		init_state(arr, s->N, s->c_cells);
+		iterate_endcount(arr, s->N, s->steps, s->model, s->params, types);
+		hist[types[1]]++;
+	}
+}
+
+static void job_pdf_rolling(Simulator *s, int k)
+{
+	int i, j;
+	int types[4];
+	int *arr = GRID(s, k), *hist = HIST(s, k);
+
+	memset(hist, 0, ((size_t) s->N * s->N + 1) * sizeof(int));
+	for (i = k; i < s->runs; i += s->threads)
+	{
+		init_state(arr, s->N, s->c_cells);
+		for (j = 0; j < s->samples; j++)
+		{
+			iterate_endcount(arr, s->N, (j == 0) ? s->init_steps : s->sample_gap, s->model, s->params, types);
+			hist[types[1]]++;
+		}
+	}
+}
+
+/* a single trajectory, on the first worker */
+static void job_iterate(Simulator *s, int k)
+{
+	if (k == 0)
+	{
+		iterate(s->array, s->N, s->steps, s->model, s->params, s->out_counts);
+	}
+}
+
+/* hitting times of the thresholds, bin max_steps + 1 for runs that never reach one */
+static void job_first_passage(Simulator *s, int k)
+{
+	int i, t, bins = s->steps + 2;
+	int *arr = GRID(s, k), *times = &s->times[(size_t) k * s->n_thresholds];
+	int *hist = &s->passage[(size_t) k * s->n_thresholds * bins];
+
+	s->simulated[k] = 0;
+	for (i = k; i < s->runs; i += s->threads)
+	{
+		init_state(arr, s->N, s->c_cells);
+		s->simulated[k] += first_passage(arr, s->N, s->steps, s->model, s->params, s->thresholds, s->n_thresholds, times);
+
+		for (t = 0; t < s->n_thresholds; t++)
+		{
+			hist[t * bins + ((times[t] < 0) ? bins - 1 : times[t])]++;
+		}
+	}
+}
+
+/* sum the worker histograms into a pdf */
+static void collect(Simulator *s, double *output, double total)
+{
+	int i, k;
+	long count;
+
+	for (i = 0; i <= s->N * s->N; i++)
+	{
+		count = 0;
+		for (k = 0; k < s->threads; k++)
+		{
+			count += HIST(s, k)[i];
+		}
+		output[i] = (double) count / total;
+	}
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* simulator handling */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+sim_alloc : create a simulator for automata of side length N
+
+args :
+	N       : side length of automata
+	threads : number of worker threads (threads >= 1)
+	seed    : seed of the first worker's stream (worker k uses seed + k),
+			  -1 to seed from the clock
+*/
+Simulator *sim_alloc(int N, int threads, long seed)
+{
+	int k;
+	size_t page;
+	Worker *w;
+	Simulator *s;
+
+	assert(N >= 1 && threads >= 1);
+
+	s = (Simulator *) calloc(1, sizeof(Simulator));
+	if (s == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	s->N = N;
+	s->threads = threads;
+	page = arr_page_ints();
+	s->grid_stride = ((size_t) N * N + page - 1) / page * page;
+	s->hist_stride = ((size_t) N * N + 1 + page - 1) / page * page;
+	s->arena = arr_alloc(threads * s->grid_stride);
+	s->hist = arr_alloc(threads * s->hist_stride);
+	s->rngs = (gsl_rng **) calloc(threads, sizeof(gsl_rng *));
+	s->workers = (pthread_t *) calloc(threads, sizeof(pthread_t));
+	if (s->rngs == NULL || s->workers == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	pthread_mutex_init(&s->call, NULL);
+	gsl_rng_env_setup();
+	for (k = 0; k < threads; k++)
+	{
+		s->rngs[k] = gsl_rng_alloc(gsl_rng_default);
+	}
+	sim_seed(s, seed);
+
+	transition_isa(); /* resolve the shared kernel before the workers start */
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->start, NULL);
+	pthread_cond_init(&s->done, NULL);
+	for (k = 0; k < threads; k++)
+	{
+		w = (Worker *) malloc(sizeof(Worker));
+		if (w == NULL)
+		{
+			fprintf(stderr, "Out of memory!");
+			exit(1);
+		}
+		w->s = s;
+		w->k = k;
+		pthread_create(&s->workers[k], NULL, worker_main, w);
+	}
+
+	run_job(s, job_touch);
+	return s;
+}
+
+/*
+sim_seed : reseed the streams of all workers (worker k uses seed + k,
+		   -1 to seed from the clock)
+*/
+void sim_seed(Simulator *s, long seed)
+{
+	int k;
+
+	if (seed < 0)
+	{
+		seed = (long) time(NULL);
+	}
+	pthread_mutex_lock(&s->call);
+	for (k = 0; k < s->threads; k++)
+	{
+		gsl_rng_set(s->rngs[k], (unsigned long int) (seed + k));
+	}
+	pthread_mutex_unlock(&s->call);
+}
+
+void sim_free(Simulator *s)
+{
+	int k;
+
+	if (s == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&s->lock);
+	s->quit = 1;
+	pthread_cond_broadcast(&s->start);
+	pthread_mutex_unlock(&s->lock);
+	for (k = 0; k < s->threads; k++)
+	{
+		pthread_join(s->workers[k], NULL);
+		gsl_rng_free(s->rngs[k]);
+	}
+
+	pthread_mutex_destroy(&s->lock);
+	pthread_mutex_destroy(&s->call);
+	pthread_cond_destroy(&s->start);
+	pthread_cond_destroy(&s->done);
+	arr_free(s->arena);
+	arr_free(s->hist);
+	free(s->rngs);
+	free(s->workers);
+	free(s);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* simulator calculating functions */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+sim_pdf : identical to pdf, using the simulator's buffers, streams and threads
+
+args :
+	output : pdf of number of cancer cells in final automata state
+			 (output must be an array of length N * N + 1)
+*/
+void sim_pdf(Simulator *s, double *output, int c_cells, int steps, int runs, modelPtr model, Params params)
+{
+	pthread_mutex_lock(&s->call);
+	s->c_cells = c_cells;
+	s->steps = steps;
+	s->runs = runs;
+	s->model = model;
+	s->params = params;
+
+	run_job(s, job_pdf);
+	collect(s, output, (double) runs);
+	pthread_mutex_unlock(&s->call);
+}
+
+/*
+sim_pdf_rolling : identical to pdf_rolling, using the simulator's buffers,
+				  streams and threads
+
+args :
+	output : pdf of number of cancer cells in the stationary state
+			 (output must be an array of length N * N + 1)
+*/
+void sim_pdf_rolling(Simulator *s, double *output, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params)
+{
+	pthread_mutex_lock(&s->call);
+	s->c_cells = c_cells;
+	s->init_steps = init_steps;
+	s->samples = samples;
+	s->sample_gap = sample_gap;
+	s->runs = runs;
+	s->model = model;
+	s->params = params;
+
+	run_job(s, job_pdf_rolling);
+	collect(s, output, (double) runs * samples);
+	pthread_mutex_unlock(&s->call);
+}
+
+/*
+sim_iterate : identical to iterate, drawing from the first worker's stream
+*/
+void sim_iterate(Simulator *s, int *array, int steps, modelPtr model, Params params, int *out_counts)
+{
+	pthread_mutex_lock(&s->call);
+	s->array = array;
+	s->steps = steps;
+	s->model = model;
+	s->params = params;
+	s->out_counts = out_counts;
+
+	run_job(s, job_iterate);
+	pthread_mutex_unlock(&s->call);
+}
+
+/*
+sim_first_passage : histograms of the first-passage times of cell type
+					count thresholds over runs from random initial states
+args :
+	c_cells      : number of initial cancer cells
+	max_steps    : most iterations of a run
+	runs         : number of runs
+	thresholds   : thresholds on the cell type counts
+	n_thresholds : number of thresholds
+
+returns :
+	hist : hist[t * (max_steps + 2) + i] is the number of runs that first met
+		   threshold t after i steps, bin max_steps + 1 counts the runs that
+		   did not within max_steps
+		   (must be integer array of length n_thresholds x (max_steps + 2))
+	long : total number of steps performed (runs stop once every threshold
+		   has been met)
+*/
+long sim_first_passage(Simulator *s, int *hist, int c_cells, int max_steps, int runs, modelPtr model, Params params, Threshold *thresholds, int n_thresholds)
+{
+	int i, k, bins = max_steps + 2;
+	long total = 0;
+
+	pthread_mutex_lock(&s->call);
+	s->c_cells = c_cells;
+	s->steps = max_steps;
+	s->runs = runs;
+	s->model = model;
+	s->params = params;
+	s->thresholds = thresholds;
+	s->n_thresholds = n_thresholds;
+	s->passage = arr_alloc((size_t) s->threads * n_thresholds * bins);
+	s->times = arr_alloc((size_t) s->threads * n_thresholds);
+	s->simulated = (long *) calloc(s->threads, sizeof(long));
+	if (s->simulated == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	run_job(s, job_first_passage);
+
+	for (i = 0; i < n_thresholds * bins; i++)
+	{
+		hist[i] = 0;
+		for (k = 0; k < s->threads; k++)
+		{
+			hist[i] += s->passage[(size_t) k * n_thresholds * bins + i];
+		}
+	}
+	for (k = 0; k < s->threads; k++)
+	{
+		total += s->simulated[k];
+	}
+
+	arr_free(s->passage);
+	arr_free(s->times);
+	free(s->simulated);
+	s->passage = NULL;
+	s->times = NULL;
+	s->simulated = NULL;
+	pthread_mutex_unlock(&s->call);
+	return total;
+}
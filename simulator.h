@@ -0,0 +1,66 @@
+/*
+  Persistent simulator
+
+  Owns the work grids, count histograms, random number streams and worker
+  threads needed by pdf / pdf_rolling / iterate, so that they are set up
+  once and reused over many calls with different Params. A simulator may
+  be shared between threads, its calls then run one at a time.
+*/
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "c_automata.h"
+#include "passage.h"
+
+typedef struct Simulator Simulator;
+
+/* job run by every worker, with the worker's index */
+typedef void (*jobPtr)(Simulator *, int);
+
+struct Simulator {
+	int N;             /* side length of automata */
+	int threads;       /* number of worker threads */
+	int *arena;        /* work grid of each worker (threads x grid_stride) */
+	int *hist;         /* count histogram of each worker (threads x hist_stride) */
+	size_t grid_stride;  /* N x N rounded up to whole pages */
+	size_t hist_stride;  /* N x N + 1 rounded up to whole pages */
+	gsl_rng **rngs;    /* random number stream of each worker */
+
+	pthread_mutex_t call;  /* held for the whole of a sim_* call */
+
+	/* worker pool */
+	pthread_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	int generation;    /* incremented for every job */
+	int pending;       /* workers still busy with the current job */
+	int quit;
+	jobPtr job;
+
+	/* arguments of the current job */
+	modelPtr model;
+	Params params;
+	int c_cells, steps, runs, init_steps, samples, sample_gap;
+	int *array, *out_counts;
+	Threshold *thresholds;
+	int n_thresholds;
+	int *passage;      /* hitting time histograms of each worker */
+	int *times;        /* hitting times of the current run of each worker */
+	long *simulated;   /* steps performed by each worker */
+};
+
+/* simulator handling */
+Simulator *sim_alloc(int N, int threads, long seed);
+void sim_free(Simulator *s);
+void sim_seed(Simulator *s, long seed);
+
+/* simulator calculating functions */
+void sim_pdf(Simulator *s, double *output, int c_cells, int steps, int runs, modelPtr model, Params params);
+void sim_pdf_rolling(Simulator *s, double *output, int c_cells, int init_steps, int samples, int sample_gap, int runs, modelPtr model, Params params);
+void sim_iterate(Simulator *s, int *array, int steps, modelPtr model, Params params, int *out_counts);
+long sim_first_passage(Simulator *s, int *hist, int c_cells, int max_steps, int runs, modelPtr model, Params params, Threshold *thresholds, int n_thresholds);
+
+#endif
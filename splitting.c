@@ -0,0 +1,186 @@
+/*
+ Multilevel splitting with Russian roulette (RESTART style)
+
+ The cancer cell count is split into regions by a list of levels. When a
+ run crosses into a higher region (towards the tail) it is cloned 'split'
+ times per level crossed and the clones share its weight. When it falls
+ back it survives with probability 1 / split per level and takes back the
+ weight. Both operations leave the expected weight of every path
+ unchanged, so the weighted histogram of final counts is an unbiased pdf
+ estimate, with most of the effort spent in the tail.
+
+ A crossing of many levels at once would ask for split^levels clones, so
+ at most MAX_CLONES are made and each takes 1 / (number of clones) of the
+ weight, which keeps the estimate unbiased.
+
+ Clones are copies of the automata state only. All runs draw from the
+ single gsl stream one after another, which is what makes clones diverge.
+ */
+
+#include <stdlib.h>
+#include "splitting.h"
+
+#define MAX_CLONES 1024  /* most clones of a run at a single step */
+
+/* a run waiting to be continued */
+typedef struct {
+	int *arr;       /* automata state */
+	double weight;  /* statistical weight */
+	int step;       /* steps already taken */
+	int region;     /* region of the cancer cell count */
+} Branch;
+
+/* stack of waiting runs */
+typedef struct {
+	Branch *items;
+	int len, cap;
+} Branches;
+
+static void push(Branches *b, int *arr, int N, double weight, int step, int region)
+{
+	Branch *t;
+
+	if (b->len == b->cap)
+	{
+		b->cap = (b->cap == 0) ? 16 : 2 * b->cap;
+		b->items = (Branch *) realloc(b->items, b->cap * sizeof(Branch));
+		if (b->items == NULL)
+		{
+			fprintf(stderr, "Out of memory!");
+			exit(1);
+		}
+	}
+
+	t = &b->items[b->len++];
+	t->arr = arr_alloc(N * N);
+	memcpy(t->arr, arr, (size_t) N * N * sizeof(int));
+	t->weight = weight;
+	t->step = step;
+	t->region = region;
+}
+
+/* region of a cancer cell count : number of levels reached */
+static int region(int count, int *levels, int n_levels, int upper)
+{
+	int k, r = 0;
+
+	for (k = 0; k < n_levels; k++)
+	{
+		if (upper ? (count >= levels[k]) : (count <= levels[k]))
+		{
+			r = k + 1;
+		}
+	}
+	return r;
+}
+
+/*
+pdf_splitting : pdf of the final number of cancer cells (as pdf) estimated
+				with multilevel splitting towards one of the tails
+
+args :
+	output   : weighted pdf of number of cancer cells in final automata state
+			   i.e. pdf(# of cancer cells = i) -> output[i]
+			   (output must be an array of length N * N + 1)
+	N        : side length of automata
+	c_cells  : number of cancer cells in initial automata state
+	steps    : steps in each automata simulation
+	runs     : number of independent starting runs
+	model    : automata iteration rules
+	params   : model parameters
+	levels   : cancer cell counts at which runs are split, increasing for
+			   the upper tail, decreasing for the lower tail
+	n_levels : number of levels
+	split    : number of clones per level crossed (split >= 2, at most
+			   MAX_CLONES clones per step)
+	upper    : 1 to split towards many cancer cells, 0 towards few
+
+returns :
+	long : total number of runs simulated (starting runs and clones)
+*/
+long pdf_splitting(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params, int *levels, int n_levels, int split, int upper)
+{
+	int i, k, r, reg, step, clones, rng_own, *arr;
+	int types[4];
+	long simulated = 0;
+	double w, factor;
+	Branches waiting = {NULL, 0, 0};
+	Branch b;
+
+	assert(split >= 2 && n_levels >= 0);
+	for (k = 1; k < n_levels; k++)
+	{
+		assert(upper ? (levels[k] > levels[k - 1]) : (levels[k] < levels[k - 1]));
+	}
+
+	rng_own = rng_initialize(-1);
+	arr = arr_alloc(N * N);
+
+	for (i = 0; i <= N * N; i++)
+	{
+		output[i] = 0.0;
+	}
+
+	for (i = 0; i < runs; i++)
+	{
+		init_state(arr, N, c_cells);
+		type_count(arr, N, types);
+		push(&waiting, arr, N, 1.0, 0, region(types[1], levels, n_levels, upper));
+
+		/* depth first through the tree of clones */
+		while (waiting.len > 0)
+		{
+			b = waiting.items[--waiting.len];
+			memcpy(arr, b.arr, (size_t) N * N * sizeof(int));
+			arr_free(b.arr);
+			w = b.weight;
+			reg = b.region;
+			simulated++;
+
+			for (step = b.step; step < steps; step++)
+			{
+				iterate_endcount(arr, N, 1, model, params, types);
+				r = region(types[1], levels, n_levels, upper);
+
+				if (r > reg) /* split */
+				{
+					factor = pow(split, r - reg);
+					clones = (factor < MAX_CLONES) ? (int) factor : MAX_CLONES;
+					w /= clones;
+					for (k = 1; k < clones; k++)
+					{
+						push(&waiting, arr, N, w, step + 1, r);
+					}
+				}
+				else if (r < reg) /* Russian roulette */
+				{
+					factor = pow(split, reg - r);
+					if (gsl_rng_uniform(rng) * factor >= 1.0)
+					{
+						w = 0.0;
+						break;
+					}
+					w *= factor;
+				}
+				reg = r;
+			}
+
+			if (w > 0.0)
+			{
+				type_count(arr, N, types);
+				output[types[1]] += w;
+			}
+		}
+	}
+
+	for (i = 0; i <= N * N; i++)
+	{
+		output[i] /= (double) runs;
+	}
+
+	free(waiting.items);
+	arr_free(arr);
+	rng_free(rng_own);
+
+	return simulated;
+}
@@ -0,0 +1,13 @@
+/*
+  Rare-event splitting for the tails of the cancer cell pdf
+*/
+
+#ifndef SPLITTING_H
+#define SPLITTING_H
+
+#include "c_automata.h"
+
+/* splitting functions */
+long pdf_splitting(double *output, int N, int c_cells, int steps, int runs, modelPtr model, Params params, int *levels, int n_levels, int split, int upper);
+
+#endif
@@ -1,13 +1,50 @@
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #include "c_automata.h"
 #include "arrays.h"
+#include "bitslice.h"
+#include "transition.h"
+#include "blocked.h"
+
+/* hardware event counter of the calling thread (-1 if the cpu or kernel does not expose it) */
+static int counter_open(unsigned int type, unsigned long long config)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void counter_print(const char *name, int fd)
+{
+	long long count;
+
+	if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+	{
+		printf(", %s n/a", name);
+		return;
+	}
+	printf(", %s %lld", name, count);
+}
 
 int main() 
 {
-	int i, j, N, *arr; 
+	int i, j, k, N, *arr; 
+	int fd[2];
 	int types[4]; 
 	/*double probs[] = {0.10, 0.60, 0.05, 0.05, 0.05};*/
-	int out_counts[4];
+	int out_counts[4 * 5];
 	Params params = params_default;
+	clock_t start;
 	
 	N = 10000; 
 	
@@ -17,7 +54,9 @@ int main()
 	
 	//arr2_print(arr, rows , cols);
 	
+	start = clock();
 	iterate_endcount(arr, N, 5, &model_simple, params, out_counts);
+	printf("model_simple : %.3f s\n", (double) (clock() - start) / CLOCKS_PER_SEC);
 	
 	//automata_print(arr, rows);
 	type_count(arr, N, types);
@@ -27,6 +66,92 @@ int main()
 		printf("%d\n", types[i]);
 	}
 	
+	/* same run through the bit-sliced engine */
+	init_state(arr, N, 5);
+	
+	start = clock();
+	iterate_bitsliced(arr, N, 5, params, out_counts);
+	printf("bit-sliced : %.3f s\n", (double) (clock() - start) / CLOCKS_PER_SEC);
+	
+	type_count(arr, N, types);
+	
+	for (i = 0; i < 4; i++)
+	{
+		printf("%d\n", types[i]);
+	}
+	
+	/* same run through the vectorised transition kernel */
+	init_state(arr, N, 5);
+	
+	start = clock();
+	iterate_endcount(arr, N, 5, &model_vector, params, out_counts);
+	printf("vector (isa %d) : %.3f s\n", transition_isa(), (double) (clock() - start) / CLOCKS_PER_SEC);
+	
+	type_count(arr, N, types);
+	
+	for (i = 0; i < 4; i++)
+	{
+		printf("%d\n", types[i]);
+	}
+	
+	/* same run through the temporally blocked engine */
+	init_state(arr, N, 5);
+	
+	start = clock();
+	iterate_blocked(arr, N, 5, 0, params, out_counts);
+	printf("blocked : %.3f s\n", (double) (clock() - start) / CLOCKS_PER_SEC);
+	
+	type_count(arr, N, types);
+	
+	for (i = 0; i < 4; i++)
+	{
+		printf("%d\n", types[i]);
+	}
+	
 	arr_free(arr);
 	
-}
\ No newline at end of file
+	/* model_extend stencils under each grid layout (same seed, so same counts) */
+	N = 2048;
+	params.alpha = 3.0;
+	params.beta = 1.0;
+	arr = arr_alloc(N * N);
+	
+	fd[0] = counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	fd[1] = counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+						 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	
+	for (j = LAYOUT_ROWMAJOR; j <= LAYOUT_MORTON; j++)
+	{
+		set_layout(j);
+		rng_initialize(1);
+		init_state(arr, N, N * N / 8);
+		
+		for (k = 0; k < 2; k++)
+		{
+			ioctl(fd[k], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd[k], PERF_EVENT_IOC_ENABLE, 0);
+		}
+		start = clock();
+		iterate_endcount(arr, N, 3, &model_extend, params, types);
+		printf("layout %d : %.3f s", j, (double) (clock() - start) / CLOCKS_PER_SEC);
+		for (k = 0; k < 2; k++)
+		{
+			ioctl(fd[k], PERF_EVENT_IOC_DISABLE, 0);
+		}
+		counter_print("cache-misses", fd[0]);
+		counter_print("dTLB-load-misses", fd[1]);
+		printf("\n");
+		arr_print(types, 4);
+		
+		rng_free(1);
+	}
+	
+	for (k = 0; k < 2; k++)
+	{
+		if (fd[k] >= 0)
+		{
+			close(fd[k]);
+		}
+	}
+	arr_free(arr);
+}
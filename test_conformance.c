@@ -0,0 +1,460 @@
+/*
+ Statistical conformance of the alternative engines
+
+ The optimised engines draw their random numbers in a different order from
+ model_simple / model_extend, so they can only be compared to the reference
+ kernels in distribution. For every case (N, Params) an engine and its
+ reference kernel are run RUNS times each from independent random initial
+ states, and the samples of
+	- the final number of cancer cells (KS and chi-square)
+	- the number of cancer and effector cells at 1/4 and 1/2 of the run (KS)
+	- the number of cancer-cancer neighbour pairs at the end (KS)
+	- the number of tumours at the end (KS)
+ are compared with two-sample tests. The tests of one engine on one case
+ share the error rate ALPHA (Bonferroni), the KS p-values are conservative
+ for the integer valued samples.
+
+ Every test prints one line of JSON
+	{"engine": "vector-avx2", "N": 16, "case": "simple", "test": "final_c_ks",
+	 "stat": 0.021, "p": 0.78, "verdict": "pass"}
+ followed by a line with "test": "all" for the engine / case.
+
+ The reference kernels under the tiled and Morton layouts draw the same
+ random numbers as under the row-major layout, so they are instead run
+ BITWISE_RUNS times with the same seeds under both layouts and must give
+ the same cell type counts at every step and the same final state. Their
+ single line has "test": "bitwise" and the number of differing runs as
+ "stat". Besides the cases above they are run on grids where the layouts
+ differ from row-major order : several tiles with partial edge tiles
+ (N = 40, 72) and a Morton grid larger than a tile (N = 64).
+
+ The exit status is the number of failed engine / case pairs.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gsl/gsl_cdf.h>
+#include "c_automata.h"
+#include "arrays.h"
+#include "bitslice.h"
+#include "transition.h"
+#include "clusters.h"
+#include "coupled.h"
+#include "blocked.h"
+
+#define RUNS 2000
+#define BITWISE_RUNS 200
+#define ALPHA 0.001
+#define SEED 12345
+
+/* sampled statistics */
+#define S_FINAL_C 0
+#define S_QUARTER_C 1
+#define S_QUARTER_E 2
+#define S_HALF_C 3
+#define S_HALF_E 4
+#define S_PAIRS 5
+#define S_TUMOURS 6
+#define N_STATS 7
+
+#define N_TESTS (N_STATS + 1)
+
+static const char *stat_names[N_STATS] = {
+	"final_c", "quarter_c", "quarter_e", "half_c", "half_e", "cc_pairs", "tumours"
+};
+
+typedef struct {
+	const char *name;
+	int N;
+	int c_cells;
+	int steps;
+	Params params;
+} Case;
+
+typedef struct {
+	const char *name;
+	modelPtr model;    /* NULL : the reference kernel under another layout */
+	int isa;           /* kernel of model_vector */
+	int layout;
+	int simple_only;   /* only defined for alpha = beta = 0 */
+} Engine;
+
+
+/* ------------------------------------------------------------------------------------- */
+/* two-sample tests */
+/* ------------------------------------------------------------------------------------- */
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Kolmogorov distribution Q(lambda) = P(K > lambda) */
+static double kolmogorov_q(double lambda)
+{
+	int k;
+	double term, sum = 0.0, sign = 1.0;
+
+	if (lambda < 0.2)
+	{
+		return 1.0;
+	}
+	for (k = 1; k <= 100; k++)
+	{
+		term = sign * 2.0 * exp(-2.0 * k * k * lambda * lambda);
+		sum += term;
+		if (fabs(term) < 1e-12)
+		{
+			break;
+		}
+		sign = -sign;
+	}
+	return fmin(fmax(sum, 0.0), 1.0);
+}
+
+/*
+ks_two_sample : two-sample Kolmogorov-Smirnov test (sorts x and y)
+
+returns :
+	stat : largest distance between the empirical distribution functions
+	double : asymptotic p-value
+*/
+static double ks_two_sample(double *x, int n, double *y, int m, double *stat)
+{
+	int i = 0, j = 0;
+	double v, d = 0.0, en;
+
+	qsort(x, n, sizeof(double), cmp_double);
+	qsort(y, m, sizeof(double), cmp_double);
+
+	while (i < n && j < m)
+	{
+		v = fmin(x[i], y[j]);
+		while (i < n && x[i] == v) i++;
+		while (j < m && y[j] == v) j++;
+		d = fmax(d, fabs((double) i / n - (double) j / m));
+	}
+
+	en = sqrt((double) n * m / (n + m));
+	*stat = d;
+	return kolmogorov_q((en + 0.12 + 0.11 / en) * d);
+}
+
+/*
+chisq_two_sample : two-sample chi-square test of integer samples in
+				   [0, max], adjacent values are pooled until each bin
+				   holds at least 10 of the two samples together
+returns :
+	stat : chi-square statistic
+	double : p-value (1 if there is a single bin)
+*/
+static double chisq_two_sample(double *x, int n, double *y, int m, int max, double *stat)
+{
+	int i, v, bins = 0;
+	long r = 0, s = 0;
+	long *hx, *hy;
+	double k1 = sqrt((double) m / n), k2 = sqrt((double) n / m), chi = 0.0;
+
+	hx = (long *) calloc(max + 1, sizeof(long));
+	hy = (long *) calloc(max + 1, sizeof(long));
+	if (hx == NULL || hy == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+	for (i = 0; i < n; i++) hx[(int) x[i]]++;
+	for (i = 0; i < m; i++) hy[(int) y[i]]++;
+
+	for (v = 0; v <= max; v++)
+	{
+		r += hx[v];
+		s += hy[v];
+		if (r + s >= 10 || (v == max && r + s > 0))
+		{
+			chi += (k1 * r - k2 * s) * (k1 * r - k2 * s) / (double) (r + s);
+			bins++;
+			r = s = 0;
+		}
+	}
+
+	free(hx);
+	free(hy);
+	*stat = chi;
+	return (bins > 1) ? gsl_cdf_chisq_Q(chi, bins - 1) : 1.0;
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* sampling */
+/* ------------------------------------------------------------------------------------- */
+
+/* number of horizontal and vertical cancer-cancer neighbour pairs */
+static int cancer_pairs(int *array, int N)
+{
+	int i, j, n = 0;
+
+	for (i = 0; i < N; i++)
+	{
+		for (j = 0; j < N; j++)
+		{
+			if (array[grid_index(N, i, j)] != T_CANCER)
+			{
+				continue;
+			}
+			n += (j + 1 < N && array[grid_index(N, i, j + 1)] == T_CANCER);
+			n += (i + 1 < N && array[grid_index(N, i + 1, j)] == T_CANCER);
+		}
+	}
+	return n;
+}
+
+/*
+sample : run a model RUNS times on a case
+
+returns :
+	samples : samples[s * RUNS + run] is statistic s of the run
+			  (must be array of length N_STATS x RUNS)
+*/
+static void sample(double *samples, Case *c, modelPtr model, long seed)
+{
+	int run, rng_own, N = c->N;
+	int *arr, *counts, *parent, *hist;
+
+	rng_own = rng_initialize(seed);
+	arr = arr_alloc(N * N);
+	counts = arr_alloc(c->steps * 4);
+	parent = arr_alloc(N * N);
+	hist = arr_alloc(N * N + 1);
+
+	for (run = 0; run < RUNS; run++)
+	{
+		init_state(arr, N, c->c_cells);
+		iterate(arr, N, c->steps, model, c->params, counts);
+
+		samples[S_FINAL_C * RUNS + run] = counts[(c->steps - 1) * 4 + T_CANCER];
+		samples[S_QUARTER_C * RUNS + run] = counts[(c->steps / 4) * 4 + T_CANCER];
+		samples[S_QUARTER_E * RUNS + run] = counts[(c->steps / 4) * 4 + T_EFFECTOR];
+		samples[S_HALF_C * RUNS + run] = counts[(c->steps / 2) * 4 + T_CANCER];
+		samples[S_HALF_E * RUNS + run] = counts[(c->steps / 2) * 4 + T_EFFECTOR];
+		samples[S_PAIRS * RUNS + run] = cancer_pairs(arr, N);
+		samples[S_TUMOURS * RUNS + run] = cluster_sizes(arr, N, parent, hist);
+	}
+
+	arr_free(arr);
+	arr_free(counts);
+	arr_free(parent);
+	arr_free(hist);
+	rng_free(rng_own);
+}
+
+
+/* a single replica of model_coupled (its state is an ordinary grid) */
+static void model_coupled_single(int *array, int N, Params params)
+{
+	model_coupled(array, 1, N, &params);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* conformance */
+/* ------------------------------------------------------------------------------------- */
+
+static void verdict(Engine *e, Case *c, const char *test, double stat, double p, int pass)
+{
+	printf("{\"engine\": \"%s\", \"N\": %d, \"case\": \"%s\", \"test\": \"%s\", "
+		   "\"stat\": %.6g, \"p\": %.6g, \"verdict\": \"%s\"}\n",
+		   e->name, c->N, c->name, test, stat, p, pass ? "pass" : "fail");
+}
+
+/*
+conform : compare an engine with the reference kernel on a case
+
+returns :
+	int : 1 if all tests pass
+*/
+static int conform(Engine *e, Case *c, double *ref, double *alt)
+{
+	int s, pass, all = 1;
+	char test[32];
+	double stat, p, p_min = 1.0, level = ALPHA / N_TESTS;
+	modelPtr reference = (c->params.alpha == 0.0 && c->params.beta == 0.0) ? model_simple : model_extend;
+
+	/* reference under row-major layout, engine with its own seed */
+	set_layout(LAYOUT_ROWMAJOR);
+	sample(ref, c, reference, SEED);
+
+	set_layout(e->layout);
+	if (e->model == model_vector)
+	{
+		transition_set_isa(e->isa);
+	}
+	sample(alt, c, (e->model != NULL) ? e->model : reference, SEED + 1);
+	set_layout(LAYOUT_ROWMAJOR);
+
+	/* chi-square on the final count before the KS tests sort the samples */
+	p = chisq_two_sample(&ref[S_FINAL_C * RUNS], RUNS, &alt[S_FINAL_C * RUNS], RUNS, c->N * c->N, &stat);
+	pass = (p >= level);
+	verdict(e, c, "final_c_chi2", stat, p, pass);
+	all &= pass;
+	p_min = fmin(p_min, p);
+
+	for (s = 0; s < N_STATS; s++)
+	{
+		p = ks_two_sample(&ref[s * RUNS], RUNS, &alt[s * RUNS], RUNS, &stat);
+		pass = (p >= level);
+		sprintf(test, "%s_ks", stat_names[s]);
+		verdict(e, c, test, stat, p, pass);
+		all &= pass;
+		p_min = fmin(p_min, p);
+	}
+
+	verdict(e, c, "all", N_TESTS, fmin(p_min * N_TESTS, 1.0), all);
+	return all;
+}
+
+/* run a reference kernel under a layout, seeded, returning the row-major final state */
+static void trajectory(int *state, int *counts, int *arr, Case *c, modelPtr model, int layout, long seed)
+{
+	int rng_own;
+
+	set_layout(layout);
+	rng_own = rng_initialize(seed);
+	init_state(arr, c->N, c->c_cells);
+	iterate(arr, c->N, c->steps, model, c->params, counts);
+	layout_export(state, arr, c->N);
+	rng_free(rng_own);
+	set_layout(LAYOUT_ROWMAJOR);
+}
+
+/*
+identical : compare the reference kernel under an engine's layout with the
+			same kernel under the row-major layout, run by run
+
+returns :
+	int : 1 if every run gives the same counts and final state
+*/
+static int identical(Engine *e, Case *c)
+{
+	int run, differ = 0, N = c->N;
+	int *arr, *ref_state, *alt_state, *ref_counts, *alt_counts;
+	modelPtr reference = (c->params.alpha == 0.0 && c->params.beta == 0.0) ? model_simple : model_extend;
+
+	arr = arr_alloc(N * N);
+	ref_state = arr_alloc(N * N);
+	alt_state = arr_alloc(N * N);
+	ref_counts = arr_alloc(c->steps * 4);
+	alt_counts = arr_alloc(c->steps * 4);
+
+	for (run = 0; run < BITWISE_RUNS; run++)
+	{
+		trajectory(ref_state, ref_counts, arr, c, reference, LAYOUT_ROWMAJOR, SEED + run);
+		trajectory(alt_state, alt_counts, arr, c, reference, e->layout, SEED + run);
+
+		differ += (memcmp(ref_counts, alt_counts, (size_t) c->steps * 4 * sizeof(int)) != 0
+				   || memcmp(ref_state, alt_state, (size_t) N * N * sizeof(int)) != 0);
+	}
+
+	arr_free(arr);
+	arr_free(ref_state);
+	arr_free(alt_state);
+	arr_free(ref_counts);
+	arr_free(alt_counts);
+
+	verdict(e, c, "bitwise", differ, (differ == 0) ? 1.0 : 0.0, differ == 0);
+	return differ == 0;
+}
+
+int main()
+{
+	int i, k, isa, failed = 0;
+	double *ref, *alt;
+	Params extend = params_default;
+	Case cases[6], layout_cases[9];
+	Engine engines[4 + 5];
+	int n_engines = 0;
+
+	extend.probs[2] = 0.3;
+	extend.alpha = 3.0;
+	extend.beta = 1.0;
+
+	cases[0] = (Case) { "simple", 16, 26, 40, params_default };
+	cases[1] = (Case) { "simple", 32, 102, 60, params_default };
+	cases[2] = (Case) { "no_competition", 16, 26, 40, params_default };
+	cases[2].params.competition = 0;
+	cases[3] = (Case) { "no_competition", 32, 102, 60, cases[2].params };
+	cases[4] = (Case) { "extend", 16, 26, 40, extend };
+	cases[5] = (Case) { "extend", 32, 102, 60, extend };
+
+	/* grids spanning several tiles, with partial edge tiles, and a Morton grid of several tiles */
+	for (i = 0; i < 3; i++)
+	{
+		layout_cases[3 * i] = (Case) { cases[2 * i].name, 40, 160, 60, cases[2 * i].params };
+		layout_cases[3 * i + 1] = (Case) { cases[2 * i].name, 64, 410, 60, cases[2 * i].params };
+		layout_cases[3 * i + 2] = (Case) { cases[2 * i].name, 72, 518, 60, cases[2 * i].params };
+	}
+
+	/* every kernel of model_vector supported by the cpu */
+	for (isa = ISA_SCALAR; isa <= ISA_AVX512; isa++)
+	{
+		if (transition_set_isa(isa) == isa)
+		{
+			engines[n_engines++] = (Engine) {
+				isa == ISA_SCALAR ? "vector-scalar" : isa == ISA_SSE4 ? "vector-sse4" : isa == ISA_AVX2 ? "vector-avx2" : "vector-avx512",
+				model_vector, isa, LAYOUT_ROWMAJOR, 1 };
+		}
+	}
+	engines[n_engines++] = (Engine) { "bitsliced", model_bitsliced, 0, LAYOUT_ROWMAJOR, 1 };
+	engines[n_engines++] = (Engine) { "blocked", model_blocked, 0, LAYOUT_ROWMAJOR, 0 };
+	engines[n_engines++] = (Engine) { "coupled", model_coupled_single, 0, LAYOUT_ROWMAJOR, 0 };
+	engines[n_engines++] = (Engine) { "layout-tiled", NULL, 0, LAYOUT_TILED, 0 };
+	engines[n_engines++] = (Engine) { "layout-morton", NULL, 0, LAYOUT_MORTON, 0 };
+
+	ref = (double *) malloc(N_STATS * RUNS * sizeof(double));
+	alt = (double *) malloc(N_STATS * RUNS * sizeof(double));
+	if (ref == NULL || alt == NULL)
+	{
+		fprintf(stderr, "Out of memory!");
+		exit(1);
+	}
+
+	for (i = 0; i < 6; i++)
+	{
+		for (k = 0; k < n_engines; k++)
+		{
+			if (engines[k].simple_only && (cases[i].params.alpha != 0.0 || cases[i].params.beta != 0.0))
+			{
+				continue;
+			}
+			if (!layout_supported(engines[k].layout, cases[i].N))
+			{
+				continue;
+			}
+			if (engines[k].model == NULL)
+			{
+				failed += !identical(&engines[k], &cases[i]);
+			}
+			else
+			{
+				failed += !conform(&engines[k], &cases[i], ref, alt);
+			}
+		}
+	}
+
+	for (i = 0; i < 9; i++)
+	{
+		for (k = 0; k < n_engines; k++)
+		{
+			if (engines[k].model == NULL && layout_supported(engines[k].layout, layout_cases[i].N))
+			{
+				failed += !identical(&engines[k], &layout_cases[i]);
+			}
+		}
+	}
+
+	free(ref);
+	free(alt);
+	transition_set_isa(-1);
+	return failed;
+}
@@ -0,0 +1,548 @@
+/*
+ Vectorised version of model_simple
+
+ Each row is swept in two parts:
+	1. the transition kernel draws the random numbers of the row, compares
+	   them against the threshold of each cell's state, writes the next
+	   states into a work row and lists the cancer cells of the row
+	2. in column order, the listed cancer cells proliferate, then the work
+	   row is written back to the automata
+
+ States move to (state + 1) % 4 on a hit, T_CANCER_TEMP cells have a zero
+ threshold and are left alone. Part 2 keeps the in-place order of
+ model_simple : a cancer cell sees its left neighbour (in the work row)
+ and the row above updated, and its right neighbour (in the automata row)
+ and the row below not yet updated. Only the random number order differs,
+ so the two models have the same law (checked by test_conformance).
+
+ Random numbers come from a counter-based generator (the splitmix64
+ output function applied to a key and a counter), one hash giving the 32
+ bit numbers of two neighbouring cells, so the kernels compute them in
+ registers (64-bit multiplies are built from 32 x 32 -> 64 bit ones) and
+ all of them give bit for bit the same results. The key is drawn from the
+ gsl rng at every step, so seeding rng_initialize seeds this engine too.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "transition.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+#define SIGN_BIT 0x80000000u
+
+/* splitmix64 constants */
+#define GOLDEN 0x9E3779B97F4A7C15ull
+#define MIX1 0xBF58476D1CE4E5B9ull
+#define MIX2 0x94D049BB133111EBull
+
+/* instruction set of the kernel in use (read and written atomically, the
+   best supported one is resolved once, on first use) */
+static int kernel_isa = ISA_SCALAR;
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+/* row work space (one per thread) */
+static __thread int ws_len = 0;
+static __thread int *ws_row = NULL;
+static __thread int *ws_next = NULL;
+static __thread int *ws_cancer = NULL;
+
+
+/* ------------------------------------------------------------------------------------- */
+/* counter-based random numbers */
+/* ------------------------------------------------------------------------------------- */
+
+/* 64 random bits for counter c */
+static inline uint64_t counter_hash(uint64_t key, uint64_t c)
+{
+	uint64_t z = key + (c + 1) * GOLDEN;
+
+	z = (z ^ (z >> 30)) * MIX1;
+	z = (z ^ (z >> 27)) * MIX2;
+	return z ^ (z >> 31);
+}
+
+/* key of a step, from the gsl rng */
+static uint64_t counter_key(void)
+{
+	return ((uint64_t) gsl_rng_get(rng) << 32) ^ (uint64_t) gsl_rng_get(rng);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* transition kernels */
+/* ------------------------------------------------------------------------------------- */
+
+/*
+transition_* : apply the unconditional transitions to the cells 'from' to
+			   n - 1 of a row ('from' must be even)
+
+args :
+	next    : next cell states
+	row     : cell states
+	key     : random number key of the step
+	counter : counter of the row, cells j and j + 1 (j even) use the low and
+			  high 32 bits of counter_hash(key, counter + j / 2)
+	t       : thresholds of states {N, C, E, D}, a cell moves on when u < t
+
+returns :
+	cancer : columns of the cancer cells, in increasing order
+	the number of cancer cells
+*/
+static int transition_scalar(int *next, const int *row, int from, int n, uint64_t key, uint64_t counter, const uint32_t *t, int *cancer)
+{
+	int k, s, nc = 0;
+	uint64_t z = 0;
+	uint32_t u;
+
+	for (k = from; k < n; k++)
+	{
+		if ((k & 1) == 0)
+		{
+			z = counter_hash(key, counter + k / 2);
+		}
+		u = (uint32_t) (z >> (32 * (k & 1)));
+		s = row[k];
+		next[k] = (s >= 0 && s < 4 && u < t[s]) ? (s + 1) & 3 : s;
+		if (s == T_CANCER)
+		{
+			cancer[nc++] = k;
+		}
+	}
+	return nc;
+}
+
+#ifdef HAVE_X86
+
+/* low 64 bits of the lane products a * (hi:lo) */
+__attribute__((target("sse4.1")))
+static inline __m128i mul64_sse4(__m128i a, __m128i lo, __m128i hi)
+{
+	__m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), lo), _mm_mul_epu32(a, hi));
+
+	return _mm_add_epi64(_mm_mul_epu32(a, lo), _mm_slli_epi64(cross, 32));
+}
+
+__attribute__((target("sse4.1")))
+static int transition_sse4(int *next, const int *row, int from, int n, uint64_t key, uint64_t counter, const uint32_t *t, int *cancer)
+{
+	int k, c, m, nc = 0;
+	__m128i z, uu, st, th, hit, nx, tb[4];
+	const __m128i bias = _mm_set1_epi32((int) SIGN_BIT);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i three = _mm_set1_epi32(3);
+	const __m128i step = _mm_set1_epi64x((long long) (2 * GOLDEN));
+	const __m128i m1lo = _mm_set1_epi64x((long long) (MIX1 & 0xFFFFFFFFu)), m1hi = _mm_set1_epi64x((long long) (MIX1 >> 32));
+	const __m128i m2lo = _mm_set1_epi64x((long long) (MIX2 & 0xFFFFFFFFu)), m2hi = _mm_set1_epi64x((long long) (MIX2 >> 32));
+
+	for (c = 0; c < 4; c++)
+	{
+		tb[c] = _mm_set1_epi32((int) (t[c] ^ SIGN_BIT));
+	}
+
+	/* splitmix64 states of the next 2 cell pairs */
+	z = _mm_set_epi64x((long long) (key + (counter + from / 2 + 2) * GOLDEN),
+					   (long long) (key + (counter + from / 2 + 1) * GOLDEN));
+
+	for (k = from; k + 4 <= n; k += 4)
+	{
+		uu = _mm_xor_si128(z, _mm_srli_epi64(z, 30));
+		uu = mul64_sse4(uu, m1lo, m1hi);
+		uu = _mm_xor_si128(uu, _mm_srli_epi64(uu, 27));
+		uu = mul64_sse4(uu, m2lo, m2hi);
+		uu = _mm_xor_si128(_mm_xor_si128(uu, _mm_srli_epi64(uu, 31)), bias);
+		z = _mm_add_epi64(z, step);
+
+		st = _mm_loadu_si128((const __m128i *) &row[k]);
+
+		/* threshold of each lane's state (biased zero for T_CANCER_TEMP) */
+		th = bias;
+		for (c = 0; c < 4; c++)
+		{
+			th = _mm_blendv_epi8(th, tb[c], _mm_cmpeq_epi32(st, _mm_set1_epi32(c)));
+		}
+
+		hit = _mm_cmpgt_epi32(th, uu); /* unsigned u < t */
+		nx = _mm_and_si128(_mm_add_epi32(st, one), three);
+		_mm_storeu_si128((__m128i *) &next[k], _mm_blendv_epi8(st, nx, hit));
+
+		m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(st, one)));
+		while (m)
+		{
+			cancer[nc++] = k + __builtin_ctz(m);
+			m &= m - 1;
+		}
+	}
+	return nc + transition_scalar(next, row, k, n, key, counter, t, cancer + nc);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mul64_avx2(__m256i a, __m256i lo, __m256i hi)
+{
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), lo), _mm256_mul_epu32(a, hi));
+
+	return _mm256_add_epi64(_mm256_mul_epu32(a, lo), _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+static int transition_avx2(int *next, const int *row, int from, int n, uint64_t key, uint64_t counter, const uint32_t *t, int *cancer)
+{
+	int k, c, m, nc = 0;
+	uint64_t z0;
+	__m256i z, uu, st, th, hit, nx, tb[4];
+	const __m256i bias = _mm256_set1_epi32((int) SIGN_BIT);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i three = _mm256_set1_epi32(3);
+	const __m256i step = _mm256_set1_epi64x((long long) (4 * GOLDEN));
+	const __m256i m1lo = _mm256_set1_epi64x((long long) (MIX1 & 0xFFFFFFFFu)), m1hi = _mm256_set1_epi64x((long long) (MIX1 >> 32));
+	const __m256i m2lo = _mm256_set1_epi64x((long long) (MIX2 & 0xFFFFFFFFu)), m2hi = _mm256_set1_epi64x((long long) (MIX2 >> 32));
+
+	for (c = 0; c < 4; c++)
+	{
+		tb[c] = _mm256_set1_epi32((int) (t[c] ^ SIGN_BIT));
+	}
+
+	z0 = key + (counter + from / 2 + 1) * GOLDEN;
+	z = _mm256_set_epi64x((long long) (z0 + 3 * GOLDEN), (long long) (z0 + 2 * GOLDEN), (long long) (z0 + GOLDEN), (long long) z0);
+
+	for (k = from; k + 8 <= n; k += 8)
+	{
+		uu = _mm256_xor_si256(z, _mm256_srli_epi64(z, 30));
+		uu = mul64_avx2(uu, m1lo, m1hi);
+		uu = _mm256_xor_si256(uu, _mm256_srli_epi64(uu, 27));
+		uu = mul64_avx2(uu, m2lo, m2hi);
+		uu = _mm256_xor_si256(_mm256_xor_si256(uu, _mm256_srli_epi64(uu, 31)), bias);
+		z = _mm256_add_epi64(z, step);
+
+		st = _mm256_loadu_si256((const __m256i *) &row[k]);
+
+		th = bias;
+		for (c = 0; c < 4; c++)
+		{
+			th = _mm256_blendv_epi8(th, tb[c], _mm256_cmpeq_epi32(st, _mm256_set1_epi32(c)));
+		}
+
+		hit = _mm256_cmpgt_epi32(th, uu);
+		nx = _mm256_and_si256(_mm256_add_epi32(st, one), three);
+		_mm256_storeu_si256((__m256i *) &next[k], _mm256_blendv_epi8(st, nx, hit));
+
+		m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(st, one)));
+		while (m)
+		{
+			cancer[nc++] = k + __builtin_ctz(m);
+			m &= m - 1;
+		}
+	}
+	return nc + transition_scalar(next, row, k, n, key, counter, t, cancer + nc);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i mul64_avx512(__m512i a, __m512i lo, __m512i hi)
+{
+	__m512i cross = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(a, 32), lo), _mm512_mul_epu32(a, hi));
+
+	return _mm512_add_epi64(_mm512_mul_epu32(a, lo), _mm512_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx512f")))
+static int transition_avx512(int *next, const int *row, int from, int n, uint64_t key, uint64_t counter, const uint32_t *t, int *cancer)
+{
+	int k, c, m, nc = 0;
+	uint64_t z0;
+	__m512i z, uu, st, th, nx, tb[4];
+	__mmask16 hit;
+	const __m512i one = _mm512_set1_epi32(1);
+	const __m512i three = _mm512_set1_epi32(3);
+	const __m512i step = _mm512_set1_epi64((long long) (8 * GOLDEN));
+	const __m512i m1lo = _mm512_set1_epi64((long long) (MIX1 & 0xFFFFFFFFu)), m1hi = _mm512_set1_epi64((long long) (MIX1 >> 32));
+	const __m512i m2lo = _mm512_set1_epi64((long long) (MIX2 & 0xFFFFFFFFu)), m2hi = _mm512_set1_epi64((long long) (MIX2 >> 32));
+
+	for (c = 0; c < 4; c++)
+	{
+		tb[c] = _mm512_set1_epi32((int) t[c]);
+	}
+
+	z0 = key + (counter + from / 2 + 1) * GOLDEN;
+	z = _mm512_add_epi64(_mm512_set1_epi64((long long) z0),
+						 _mm512_set_epi64((long long) (7 * GOLDEN), (long long) (6 * GOLDEN), (long long) (5 * GOLDEN), (long long) (4 * GOLDEN),
+										  (long long) (3 * GOLDEN), (long long) (2 * GOLDEN), (long long) GOLDEN, 0));
+
+	for (k = from; k + 16 <= n; k += 16)
+	{
+		uu = _mm512_xor_si512(z, _mm512_srli_epi64(z, 30));
+		uu = mul64_avx512(uu, m1lo, m1hi);
+		uu = _mm512_xor_si512(uu, _mm512_srli_epi64(uu, 27));
+		uu = mul64_avx512(uu, m2lo, m2hi);
+		uu = _mm512_xor_si512(uu, _mm512_srli_epi64(uu, 31));
+		z = _mm512_add_epi64(z, step);
+
+		st = _mm512_loadu_si512((const void *) &row[k]);
+
+		th = _mm512_setzero_si512();
+		for (c = 0; c < 4; c++)
+		{
+			th = _mm512_mask_blend_epi32(_mm512_cmpeq_epi32_mask(st, _mm512_set1_epi32(c)), th, tb[c]);
+		}
+
+		hit = _mm512_cmplt_epu32_mask(uu, th);
+		nx = _mm512_and_si512(_mm512_add_epi32(st, one), three);
+		_mm512_storeu_si512((void *) &next[k], _mm512_mask_blend_epi32(hit, st, nx));
+
+		m = (int) _mm512_cmpeq_epi32_mask(st, one);
+		while (m)
+		{
+			cancer[nc++] = k + __builtin_ctz(m);
+			m &= m - 1;
+		}
+	}
+	return nc + transition_scalar(next, row, k, n, key, counter, t, cancer + nc);
+}
+
+#endif
+
+
+/* ------------------------------------------------------------------------------------- */
+/* kernel selection */
+/* ------------------------------------------------------------------------------------- */
+
+/* kernels by instruction set */
+static const transitionPtr kernels[4] = {
+	transition_scalar,
+#ifdef HAVE_X86
+	transition_sse4, transition_avx2, transition_avx512
+#else
+	transition_scalar, transition_scalar, transition_scalar
+#endif
+};
+
+/* best instruction set supported by the cpu, not above 'isa' */
+static int supported_isa(int isa)
+{
+#ifdef HAVE_X86
+	__builtin_cpu_init();
+	if (isa >= ISA_AVX512 && __builtin_cpu_supports("avx512f"))
+	{
+		return ISA_AVX512;
+	}
+	if (isa >= ISA_AVX2 && __builtin_cpu_supports("avx2"))
+	{
+		return ISA_AVX2;
+	}
+	if (isa >= ISA_SSE4 && __builtin_cpu_supports("sse4.1"))
+	{
+		return ISA_SSE4;
+	}
+#endif
+	return ISA_SCALAR;
+}
+
+static void kernel_default(void)
+{
+	__atomic_store_n(&kernel_isa, supported_isa(ISA_AVX512), __ATOMIC_RELAXED);
+}
+
+/*
+transition_set_isa : select the transition kernel
+
+The kernel is shared by all threads, so it should not be changed while a
+Simulator (or another thread) runs model_vector : the kernels give bit for
+bit the same results, but a run would then use a mix of them.
+
+args :
+	isa : requested instruction set (ISA_SCALAR ... ISA_AVX512),
+		  or -1 for the best one supported by the cpu
+
+returns :
+	the instruction set in use, the best supported one not above 'isa'
+*/
+int transition_set_isa(int isa)
+{
+	pthread_once(&kernel_once, kernel_default);
+	isa = supported_isa((isa < 0) ? ISA_AVX512 : isa);
+	__atomic_store_n(&kernel_isa, isa, __ATOMIC_RELAXED);
+	return isa;
+}
+
+/*
+transition_isa : instruction set of the kernel used by model_vector
+*/
+int transition_isa(void)
+{
+	pthread_once(&kernel_once, kernel_default);
+	return __atomic_load_n(&kernel_isa, __ATOMIC_RELAXED);
+}
+
+
+/* ------------------------------------------------------------------------------------- */
+/* iteration functions */
+/* ------------------------------------------------------------------------------------- */
+
+/* probability -> 32 bit fixed point threshold (u < t <=> r < p) */
+static uint32_t prob_threshold(double p)
+{
+	double t;
+
+	if (p <= 0.0)
+	{
+		return 0;
+	}
+	t = ceil(p * 4294967296.0);
+	return (t >= 4294967295.0) ? 0xFFFFFFFFu : (uint32_t) t;
+}
+
+/*
+row_proliferate : proliferate for the cancer cell (i, j) of the row being
+				  swept, given 64 random bits z
+args :
+	next : work row (states after the update, left neighbours)
+	row  : row before the update (right neighbours)
+	t_prolif : thresholds of k1_prime by number of cancer neighbours
+*/
+static inline void row_proliferate(int *array, int N, int rowmajor, int i, int j, int *next, const int *row,
+								   uint64_t z, const uint32_t *t_prolif, int competition)
+{
+	int k, neigh_c = 0, neigh_n = 0, v[4];
+	int *norm_neighbours[4], *p[4];
+
+	/* neighbours in the order of order_neighbours : right, down, left, up */
+	p[0] = (j + 1 < N) ? &next[j + 1] : NULL;
+	p[1] = (i + 1 < N) ? &array[rowmajor ? (size_t) (i + 1) * N + j : (size_t) grid_index(N, i + 1, j)] : NULL;
+	p[2] = (j > 0) ? &next[j - 1] : NULL;
+	p[3] = (i > 0) ? &array[rowmajor ? (size_t) (i - 1) * N + j : (size_t) grid_index(N, i - 1, j)] : NULL;
+	v[0] = (p[0] != NULL) ? row[j + 1] : -1; /* the right neighbour is seen before its update */
+	v[1] = (p[1] != NULL) ? *p[1] : -1;
+	v[2] = (p[2] != NULL) ? *p[2] : -1;
+	v[3] = (p[3] != NULL) ? *p[3] : -1;
+
+	for (k = 0; k < 4; k++)
+	{
+		if (v[k] == T_NORMAL)
+		{
+			norm_neighbours[neigh_n++] = p[k];
+		}
+		else if (v[k] == T_CANCER)
+		{
+			neigh_c++;
+		}
+	}
+
+	/* decide if cancer proliferates (k1_prime = k1 * (1 - neigh_c / 4) with competition) */
+	if (neigh_n > 0 && (uint32_t) (z >> 32) < t_prolif[competition ? neigh_c : 0])
+	{
+		/* choose a normal cell to invade */
+		*(norm_neighbours[((z & 0xFFFFFFFFu) * (uint64_t) neigh_n) >> 32]) = T_CANCER_TEMP;
+	}
+}
+
+/*
+model_vector : apply the model_simple rules with the vectorised transition
+			   kernel
+args:
+	array : automata state
+	N	  : side length of automata
+
+params **
+	prob  : transition probabilities {k0, k1, k2, k3, k4} of
+			automata states.
+	competition : cancer cells compete for resources
+*/
+void model_vector(int *array, int N, Params params)
+{
+	int i, j, k, id, nc, rowmajor;
+	int *row;
+	uint32_t t[4], t_prolif[5];
+	uint64_t key, half = (uint64_t) (N + 1) / 2;
+	transitionPtr kernel = kernels[transition_isa()];
+
+	/* grow row work space */
+	if (ws_len < N)
+	{
+		free(ws_row);
+		free(ws_next);
+		free(ws_cancer);
+		ws_row = (int *) malloc(N * sizeof(int));
+		ws_next = (int *) malloc(N * sizeof(int));
+		ws_cancer = (int *) malloc(N * sizeof(int));
+		if (ws_row == NULL || ws_next == NULL || ws_cancer == NULL)
+		{
+			fprintf(stderr, "Out of memory!");
+			exit(1);
+		}
+		ws_len = N;
+	}
+
+	/* thresholds of N -> C, C -> E, E -> D, D -> N */
+	t[0] = prob_threshold(params.probs[0]);
+	t[1] = prob_threshold(params.probs[2]);
+	t[2] = prob_threshold(params.probs[3]);
+	t[3] = prob_threshold(params.probs[4]);
+	for (k = 0; k < 5; k++)
+	{
+		t_prolif[k] = prob_threshold(params.probs[1] * (1 - ((double) k) / 4.00));
+	}
+
+	key = counter_key();
+
+	/* rows are contiguous only in the row-major layout */
+	rowmajor = (grid_layout == LAYOUT_ROWMAJOR);
+
+	for (i = 0; i < N; i++)
+	{
+		if (rowmajor)
+		{
+			row = &array[(size_t) N * i];
+		}
+		else
+		{
+			row = ws_row;
+			for (j = 0; j < N; j++)
+			{
+				row[j] = array[grid_index(N, i, j)];
+			}
+		}
+
+		/* next states of the row, cell pairs use counters i * half ... */
+		nc = (*kernel)(ws_next, row, 0, N, key, (uint64_t) i * half, t, ws_cancer);
+
+		/* proliferate in the order of model_simple (counters after those of the cells) */
+		for (k = 0; k < nc; k++)
+		{
+			j = ws_cancer[k];
+			row_proliferate(array, N, rowmajor, i, j, ws_next, row,
+							counter_hash(key, (uint64_t) N * half + (uint64_t) N * i + j), t_prolif, params.competition);
+		}
+
+		if (rowmajor)
+		{
+			memcpy(row, ws_next, N * sizeof(int));
+		}
+		else
+		{
+			for (j = 0; j < N; j++)
+			{
+				array[grid_index(N, i, j)] = ws_next[j];
+			}
+		}
+	}
+
+	for (id = 0; id < N * N; id++)
+	{
+		if (array[id] == T_CANCER_TEMP)
+		{
+			array[id] = T_CANCER;
+		}
+	}
+}
+
+/* free the row work space of model_vector in the calling thread */
+void model_vector_release(void)
+{
+	free(ws_row);
+	free(ws_next);
+	free(ws_cancer);
+	ws_row = ws_next = ws_cancer = NULL;
+	ws_len = 0;
+}
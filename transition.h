@@ -0,0 +1,36 @@
+/*
+  Vectorised state transition kernel for model_simple
+
+  The random numbers and unconditional transitions (N -> C, C -> E,
+  E -> D, D -> N) of a row are computed a vector at a time, the
+  instruction set is chosen at run time.
+*/
+
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <stdint.h>
+#include "c_automata.h"
+
+/* instruction sets of the transition kernel */
+#define ISA_SCALAR 0
+#define ISA_SSE4 1
+#define ISA_AVX2 2
+#define ISA_AVX512 3
+
+/* transition kernel function pointer */
+/* writes the next states of the cells 'from' to n - 1 of a row given their
+   states, the random number key and counter of the row and the thresholds
+   of states {N, C, E, D}, lists the cancer cells and returns their number */
+typedef int (*transitionPtr)(int *, const int *, int, int, uint64_t, uint64_t, const uint32_t *, int *);
+
+/* kernel selection (shared by all threads, not to be changed while a
+   Simulator runs model_vector) */
+int transition_set_isa(int isa);
+int transition_isa(void);
+
+/* iteration functions */
+void model_vector(int *array, int N, Params params);
+void model_vector_release(void);
+
+#endif